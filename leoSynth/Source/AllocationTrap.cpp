@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "AllocationTrap.h"
+
+#if LEOSYNTH_ALLOCATION_TRAP
+
+#include <cstdlib>
+#include <new>
+
+// Only applications: in a plugin loaded with dlopen the first touch of a
+// thread_local can itself call malloc
+#if defined (__GLIBC__) && JUCE_STANDALONE_APPLICATION
+ #define LEOSYNTH_TRAP_MALLOC 1
+
+extern "C" void* __libc_malloc (size_t);
+extern "C" void* __libc_calloc (size_t, size_t);
+extern "C" void* __libc_realloc (void*, size_t);
+#else
+ #define LEOSYNTH_TRAP_MALLOC 0
+#endif
+
+namespace
+{
+    thread_local bool realtime = false;
+    std::atomic<juce::uint64> numAllocations { 0 };
+
+    void check() noexcept
+    {
+        if (! realtime)
+            return;
+
+        // Disarmed while reporting, the assertion handler may allocate itself
+        realtime = false;
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+        jassertfalse;   // heap allocation on the audio thread
+        realtime = true;
+    }
+
+    void* rawMalloc (std::size_t size) noexcept
+    {
+       #if LEOSYNTH_TRAP_MALLOC
+        return __libc_malloc (size);
+       #else
+        return std::malloc (size);
+       #endif
+    }
+}
+
+namespace AllocationTrap
+{
+    ScopedRealtime::ScopedRealtime() noexcept
+        : wasRealtime (realtime)
+    {
+        realtime = true;
+    }
+
+    ScopedRealtime::~ScopedRealtime() noexcept
+    {
+        realtime = wasRealtime;
+    }
+
+    juce::uint64 getNumAllocations() noexcept
+    {
+        return numAllocations.load (std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+// The array, nothrow and sized forms all end up in these two
+void* operator new (std::size_t size)
+{
+    check();
+
+    if (auto* p = rawMalloc (size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    std::free (p);
+}
+
+#if LEOSYNTH_TRAP_MALLOC
+extern "C" void* malloc (size_t size)
+{
+    check();
+    return __libc_malloc (size);
+}
+
+extern "C" void* calloc (size_t count, size_t size)
+{
+    check();
+    return __libc_calloc (count, size);
+}
+
+extern "C" void* realloc (void* p, size_t size)
+{
+    check();
+    return __libc_realloc (p, size);
+}
+#endif
+
+#endif
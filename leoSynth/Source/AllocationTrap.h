@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    AllocationTrap.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef LEOSYNTH_ALLOCATION_TRAP
+ #define LEOSYNTH_ALLOCATION_TRAP 0
+#endif
+
+// Debug aid: with LEOSYNTH_ALLOCATION_TRAP=1 the global operator new (and, in
+// glibc applications, malloc, calloc and realloc) is replaced by a version that
+// jasserts when it runs on a thread inside a ScopedRealtime, i.e. processBlock
+// or a render worker. Every hit is counted too, so a headless run can fail on
+// it. Without the flag ScopedRealtime is empty and nothing is replaced.
+namespace AllocationTrap
+{
+   #if LEOSYNTH_ALLOCATION_TRAP
+    class ScopedRealtime
+    {
+    public:
+        ScopedRealtime() noexcept;
+        ~ScopedRealtime() noexcept;
+
+    private:
+        const bool wasRealtime;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    juce::uint64 getNumAllocations() noexcept;
+   #else
+    struct ScopedRealtime
+    {
+        ScopedRealtime() noexcept {}
+    };
+
+    inline juce::uint64 getNumAllocations() noexcept { return 0; }
+   #endif
+
+    constexpr bool isEnabled() noexcept { return LEOSYNTH_ALLOCATION_TRAP != 0; }
+}
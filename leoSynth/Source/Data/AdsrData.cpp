@@ -9,12 +9,356 @@
 
 #include "AdsrData.h"
 
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+    constexpr int width = (int) Vec::SIMDNumElements;
+
+    // How far past its end an exponential segment aims, as a fraction of its
+    // span: a soft knee for the attack, close to a true exponential otherwise
+    constexpr double attackOvershoot = 0.3;
+    constexpr double decayOvershoot = 0.001;
+
+    inline float clamp (float value, float low, float high) noexcept
+    {
+        return juce::jlimit (low, high, value);
+    }
+
+    // out[i] = start + step * (i + 1), from the index so nothing accumulates
+    void rampLinear (float* out, int numSamples, float start, float step, float low, float high)
+    {
+        int i = 0;
+
+        for (; i < numSamples && ! Vec::isSIMDAligned (out + i); ++i)
+            out[i] = clamp (start + step * (float) (i + 1), low, high);
+
+        if (i + width <= numSamples)
+        {
+            alignas (64) float lanes[width];
+
+            for (int k = 0; k < width; ++k)
+                lanes[k] = (float) (i + k + 1);
+
+            auto index = Vec::fromRawArray (lanes);
+            const auto vStart = Vec::expand (start);
+            const auto vStep = Vec::expand (step);
+            const auto vLow = Vec::expand (low);
+            const auto vHigh = Vec::expand (high);
+
+            for (; i + width <= numSamples; i += width)
+            {
+                Vec::max (vLow, Vec::min (vHigh, vStart + vStep * index)).copyToRawArray (out + i);
+                index += (float) width;
+            }
+        }
+
+        for (; i < numSamples; ++i)
+            out[i] = clamp (start + step * (float) (i + 1), low, high);
+    }
+
+    // out[i] = aim + distance * mul^(i + 1); each lane carries its own power
+    void rampExponential (float* out, int numSamples, float aim, float distance, float mul, float low, float high)
+    {
+        auto offset = distance * mul;
+        int i = 0;
+
+        for (; i < numSamples && ! Vec::isSIMDAligned (out + i); ++i)
+        {
+            out[i] = clamp (aim + offset, low, high);
+            offset *= mul;
+        }
+
+        if (i + width <= numSamples)
+        {
+            alignas (64) float lanes[width];
+            auto stride = 1.0f;
+
+            for (int k = 0; k < width; ++k)
+            {
+                lanes[k] = offset * stride;
+                stride *= mul;
+            }
+
+            auto offsets = Vec::fromRawArray (lanes);
+            const auto vAim = Vec::expand (aim);
+            const auto vStride = Vec::expand (stride);
+            const auto vLow = Vec::expand (low);
+            const auto vHigh = Vec::expand (high);
+
+            for (; i + width <= numSamples; i += width)
+            {
+                Vec::max (vLow, Vec::min (vHigh, vAim + offsets)).copyToRawArray (out + i);
+                offsets *= vStride;
+            }
+
+            offset = offsets.get (0);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            out[i] = clamp (aim + offset, low, high);
+            offset *= mul;
+        }
+    }
+}
+
+//==============================================================================
+AdsrData::Segment AdsrData::makeSegment (Curve curve, float end, float span, float seconds, double sampleRate)
+{
+    const auto numSamples = juce::jmax (1.0, (double) seconds * sampleRate);
+
+    if (curve == linear || span == 0.0f)
+        return { 1.0f, (float) (span / numSamples), end, end };
+
+    // From end - span, the curve reaches end after numSamples
+    const auto overshoot = span > 0.0f ? attackOvershoot : decayOvershoot;
+    const auto aim = (double) end + overshoot * span;
+    const auto mul = std::exp (-std::log ((1.0 + overshoot) / overshoot) / numSamples);
+
+    return { (float) mul, (float) (aim * (1.0 - mul)), end, (float) aim };
+}
+
+float AdsrData::advance (const Segment& segment, float level, int numSamples)
+{
+    if (segment.mul == 1.0f)
+        return level + segment.add * (float) numSamples;
+
+    return segment.aim + (level - segment.aim) * (float) std::pow ((double) segment.mul, (double) numSamples);
+}
+
+//==============================================================================
+void AdsrData::setSampleRate (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    if (stage != Stage::idle)
+        enterStage (stage);
+}
+
 void AdsrData::updateADSR (const float attack, const float decay, const float sustain, const float release)
 {
-    adsrParams.attack = attack;
-    adsrParams.decay = decay;
-    adsrParams.sustain = sustain;
-    adsrParams.release = release;
-    
-    setParameters (adsrParams);
+    const auto releaseChanged = release != params.release;
+    params = { attack, decay, sustain, release };
+
+    // A release is timed from the level it started at, so it is only restarted
+    // when its own time moves; attack and decay do not depend on the level
+    if (stage == Stage::attack || stage == Stage::decay || stage == Stage::sustain
+         || (stage == Stage::release && releaseChanged))
+        enterStage (stage);
+}
+
+void AdsrData::setCurve (Curve newCurve)
+{
+    if (newCurve == curve)
+        return;
+
+    curve = newCurve;
+
+    if (stage != Stage::idle)
+        enterStage (stage);
+}
+
+void AdsrData::noteOn()
+{
+    // From the current level, so a retriggered voice does not click
+    enterStage (Stage::attack);
+}
+
+void AdsrData::noteOff()
+{
+    if (stage != Stage::idle)
+        enterStage (Stage::release);
+}
+
+void AdsrData::reset()
+{
+    stage = Stage::idle;
+    level = 0.0f;
+    segment = {};
+}
+
+//==============================================================================
+void AdsrData::enterStage (Stage newStage)
+{
+    stage = newStage;
+
+    switch (stage)
+    {
+        case Stage::attack:
+            if (params.attack > 0.0f && level < 1.0f)
+            {
+                segment = makeSegment (curve, 1.0f, 1.0f, params.attack, sampleRate);
+                return;
+            }
+
+            level = 1.0f;
+            enterStage (Stage::decay);
+            return;
+
+        case Stage::decay:
+            if (params.decay > 0.0f && level > params.sustain)
+            {
+                segment = makeSegment (curve, params.sustain, params.sustain - 1.0f, params.decay, sampleRate);
+                return;
+            }
+
+            enterStage (Stage::sustain);
+            return;
+
+        case Stage::sustain:
+            level = params.sustain;
+            segment = { 1.0f, 0.0f, level, level };
+            return;
+
+        case Stage::release:
+            if (params.release > 0.0f && level > 0.0f)
+            {
+                segment = makeSegment (curve, 0.0f, -level, params.release, sampleRate);
+                return;
+            }
+
+            reset();
+            return;
+
+        case Stage::idle:
+            reset();
+            return;
+    }
+}
+
+void AdsrData::finishStage()
+{
+    level = segment.end;
+
+    if (stage == Stage::attack)
+        enterStage (Stage::decay);
+    else if (stage == Stage::decay)
+        enterStage (Stage::sustain);
+    else if (stage == Stage::release)
+        reset();
+}
+
+int AdsrData::samplesLeftInStage() const
+{
+    // Counting the sample that lands on the end
+    double n;
+
+    if (segment.mul == 1.0f)
+        n = segment.add != 0.0f ? ((double) segment.end - level) / segment.add : 1.0e9;
+    else
+        n = std::log (((double) segment.end - segment.aim) / ((double) level - segment.aim)) / std::log ((double) segment.mul);
+
+    if (! (n > 1.0))
+        return 1;
+
+    // A hair over a whole sample is rounding, not one more sample of the stage
+    return (int) std::ceil (juce::jmin (n, 1.0e9) - 1.0e-3);
+}
+
+void AdsrData::renderRun (float* envelope, int numSamples) const
+{
+    const auto low = juce::jmin (level, segment.end);
+    const auto high = juce::jmax (level, segment.end);
+
+    if (segment.mul == 1.0f)
+        rampLinear (envelope, numSamples, level, segment.add, low, high);
+    else
+        rampExponential (envelope, numSamples, segment.aim, level - segment.aim, segment.mul, low, high);
+}
+
+//==============================================================================
+void AdsrData::render (float* envelope, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        if (stage == Stage::idle)
+        {
+            juce::FloatVectorOperations::clear (envelope, numSamples);
+            return;
+        }
+
+        if (stage == Stage::sustain)
+        {
+            level = params.sustain;
+            juce::FloatVectorOperations::fill (envelope, level, numSamples);
+            return;
+        }
+
+        const auto left = samplesLeftInStage();
+        const auto run = juce::jmin (numSamples, left);
+
+        renderRun (envelope, run);
+
+        if (run == left)
+        {
+            envelope[run - 1] = segment.end;
+            finishStage();
+        }
+        else
+        {
+            level = envelope[run - 1];
+        }
+
+        envelope += run;
+        numSamples -= run;
+    }
+}
+
+void AdsrData::applyEnvelopeToBuffer (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    jassert (startSample + numSamples <= buffer.getNumSamples());
+
+    if (stage == Stage::idle)
+    {
+        buffer.clear (startSample, numSamples);
+        return;
+    }
+
+    if (stage == Stage::sustain)
+    {
+        level = params.sustain;
+        buffer.applyGain (startSample, numSamples, level);
+        return;
+    }
+
+    constexpr int chunkSize = 256;
+    alignas (64) float envelope[chunkSize];
+
+    while (numSamples > 0)
+    {
+        const auto n = juce::jmin (numSamples, chunkSize);
+        render (envelope, n);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::multiply (buffer.getWritePointer (ch, startSample), envelope, n);
+
+        startSample += n;
+        numSamples -= n;
+    }
+}
+
+float AdsrData::skip (int numSamples)
+{
+    while (numSamples > 0 && stage != Stage::idle)
+    {
+        if (stage == Stage::sustain)
+        {
+            level = params.sustain;
+            break;
+        }
+
+        const auto left = samplesLeftInStage();
+
+        if (numSamples < left)
+        {
+            level = juce::jlimit (juce::jmin (level, segment.end), juce::jmax (level, segment.end),
+                                  advance (segment, level, numSamples));
+            break;
+        }
+
+        numSamples -= left;
+        finishStage();
+    }
+
+    return level;
 }
@@ -11,11 +11,73 @@
 
 #include <JuceHeader.h>
 
-class AdsrData : public juce::ADSR
+// ADSR envelope made of segments. Every stage is the recurrence
+// level' = level * mul + add: a straight line when mul is 1, otherwise an
+// RC-style curve aimed a little past the stage's end. The n-th value of such a
+// run has a closed form, so the length of a stage is known up front: render()
+// fills whole runs a SIMD register at a time with no per-sample branches, and
+// skip() jumps ahead without writing anything, which is all a control-rate
+// modulator needs.
+//
+// Times mean what they do in juce::ADSR: attack and decay cover the full 0..1
+// and 1..sustain spans, release starts from wherever the level is.
+class AdsrData
 {
 public:
+    enum Curve { linear, exponential };
+
+    struct Segment
+    {
+        float mul { 1.0f };
+        float add { 0.0f };
+        float end { 0.0f };
+        float aim { 0.0f };   // where an exponential segment is heading
+    };
+
+    // A stage that moves by span (signed) over the given time and stops at end
+    static Segment makeSegment (Curve curve, float end, float span, float seconds, double sampleRate);
+
+    // The level numSamples into a segment, before clamping to its end
+    static float advance (const Segment& segment, float level, int numSamples);
+
+    void setSampleRate (double newSampleRate);
     void updateADSR (const float attack, const float decay, const float sustain, const float release);
-    
+    void setCurve (Curve newCurve);
+
+    void noteOn();
+    void noteOff();
+    void reset();
+
+    bool isActive() const noexcept { return stage != Stage::idle; }
+    float getLevel() const noexcept { return level; }
+
+    // Writes the next numSamples values, for use as a VCA or a modulation source
+    void render (float* envelope, int numSamples);
+
+    // Multiplies every channel of the range by the envelope
+    void applyEnvelopeToBuffer (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // Moves numSamples ahead without rendering and returns the level there
+    float skip (int numSamples);
+
 private:
-    juce::ADSR::Parameters adsrParams;
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    void enterStage (Stage newStage);
+    void finishStage();
+    int samplesLeftInStage() const;
+    void renderRun (float* envelope, int numSamples) const;
+
+    struct Parameters
+    {
+        float attack { 0.1f }, decay { 0.1f }, sustain { 1.0f }, release { 0.1f };
+    };
+
+    Parameters params;
+    Curve curve { linear };
+    double sampleRate { 44100.0 };
+
+    Stage stage { Stage::idle };
+    float level { 0.0f };
+    Segment segment;
 };
@@ -9,3 +9,170 @@
 */
 
 #include "DelayData.h"
+
+void DelayData::prepareToPlay (double newSampleRate, int samplesPerBlock, int outputChannels)
+{
+    juce::ignoreUnused (samplesPerBlock, outputChannels);
+    sampleRate = newSampleRate;
+
+    maxDelaySamples = (float) std::ceil (maxDelayMs * 0.001 * sampleRate);
+    size = juce::nextPowerOfTwo ((int) maxDelaySamples + 2);
+    mask = size - 1;
+
+    for (auto& line : lines)
+        line.calloc ((size_t) size + 1);
+
+    dampingCoefficient = (float) (1.0 - std::exp (-juce::MathConstants<double>::twoPi
+                                                   * juce::jmin ((double) feedbackCutoff, 0.45 * sampleRate) / sampleRate));
+
+    for (auto* smoother : { &delaySamples, &feedback, &mix })
+        smoother->reset (sampleRate, smoothingSeconds);
+
+    // The first setParams after this lands without a glide
+    snapToTarget = true;
+    reset();
+}
+
+void DelayData::setParams (const float timeMs, const float feedbackAmount, const float mixAmount)
+{
+    delaySamples.setTargetValue (juce::jlimit (1.0f, maxDelaySamples, timeMs * 0.001f * (float) sampleRate));
+    feedback.setTargetValue (juce::jlimit (0.0f, 0.99f, feedbackAmount));
+    mix.setTargetValue (juce::jlimit (0.0f, 1.0f, mixAmount));
+
+    if (snapToTarget)
+    {
+        for (auto* smoother : { &delaySamples, &feedback, &mix })
+            smoother->setCurrentAndTargetValue (smoother->getTargetValue());
+
+        snapToTarget = false;
+    }
+}
+
+void DelayData::reset()
+{
+    for (auto& line : lines)
+        if (line != nullptr)
+            juce::FloatVectorOperations::clear (line.get(), size + 1);
+
+    dampingState.fill (0.0f);
+    writeIndex = 0;
+}
+
+void DelayData::process (juce::AudioBuffer<float>& buffer, const int numSamples)
+{
+    if (size == 0)
+        return;
+
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), maxChannels);
+    auto* const* channels = buffer.getArrayOfWritePointers();
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto remaining = juce::jmin (numSamples - start, chunkSize);
+        const auto steady = ! (delaySamples.isSmoothing() || feedback.isSmoothing() || mix.isSmoothing());
+
+        // A steady chunk must end before the first sample it writes is read back
+        const auto steadyLength = juce::jmin (remaining, (int) delaySamples.getCurrentValue() - 1);
+        int n;
+
+        if (steady && steadyLength > 0)
+        {
+            n = steadyLength;
+            processSteady (channels, numChannels, start, n);
+        }
+        else
+        {
+            n = remaining;
+            processGliding (channels, numChannels, start, n);
+        }
+
+        writeIndex = (writeIndex + n) & mask;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            lines[(size_t) ch][size] = lines[(size_t) ch][0];
+
+        start += n;
+    }
+}
+
+void DelayData::processSteady (float* const* channels, const int numChannels, const int start, const int numSamples)
+{
+    const auto delay = delaySamples.getCurrentValue();
+    const auto whole = (int) delay;
+    const auto fraction = delay - (float) whole;
+    const auto gain = feedback.getCurrentValue();
+    const auto wet = mix.getCurrentValue();
+
+    // delayed[i] = line[r + i] * fraction + line[r + i + 1] * (1 - fraction)
+    const auto readIndex = (writeIndex - whole - 1) & mask;
+    const auto readFirst = juce::jmin (numSamples, size - readIndex);
+    const auto writeFirst = juce::jmin (numSamples, size - writeIndex);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* line = lines[(size_t) ch].get();
+        auto* x = channels[ch] + start;
+
+        juce::FloatVectorOperations::copyWithMultiply (delayed, line + readIndex, fraction, readFirst);
+        juce::FloatVectorOperations::addWithMultiply (delayed, line + readIndex + 1, 1.0f - fraction, readFirst);
+
+        if (readFirst < numSamples)
+        {
+            juce::FloatVectorOperations::copyWithMultiply (delayed + readFirst, line, fraction, numSamples - readFirst);
+            juce::FloatVectorOperations::addWithMultiply (delayed + readFirst, line + 1, 1.0f - fraction, numSamples - readFirst);
+        }
+
+        auto state = dampingState[(size_t) ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            state += dampingCoefficient * (delayed[i] - state);
+            damped[i] = state;
+        }
+
+        dampingState[(size_t) ch] = state;
+
+        juce::FloatVectorOperations::copy (line + writeIndex, x, writeFirst);
+        juce::FloatVectorOperations::addWithMultiply (line + writeIndex, damped, gain, writeFirst);
+
+        if (writeFirst < numSamples)
+        {
+            juce::FloatVectorOperations::copy (line, x + writeFirst, numSamples - writeFirst);
+            juce::FloatVectorOperations::addWithMultiply (line, damped + writeFirst, gain, numSamples - writeFirst);
+        }
+
+        juce::FloatVectorOperations::multiply (x, 1.0f - wet, numSamples);
+        juce::FloatVectorOperations::addWithMultiply (x, delayed, wet, numSamples);
+    }
+}
+
+void DelayData::processGliding (float* const* channels, const int numChannels, const int start, const int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        delayRamp[i] = delaySamples.getNextValue();
+        feedbackRamp[i] = feedback.getNextValue();
+        mixRamp[i] = mix.getNextValue();
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* line = lines[(size_t) ch].get();
+        auto* x = channels[ch] + start;
+        auto state = dampingState[(size_t) ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto whole = (int) delayRamp[i];
+            const auto fraction = delayRamp[i] - (float) whole;
+            const auto readIndex = (writeIndex + i - whole - 1) & mask;
+            const auto y = line[readIndex] * fraction + line[(readIndex + 1) & mask] * (1.0f - fraction);
+
+            state += dampingCoefficient * (y - state);
+            line[(writeIndex + i) & mask] = x[i] + feedbackRamp[i] * state;
+            x[i] += mixRamp[i] * (y - x[i]);
+        }
+
+        dampingState[(size_t) ch] = state;
+    }
+}
@@ -11,13 +11,54 @@
 #pragma once
 #include <JuceHeader.h>
 
+// Stereo feedback delay for the master bus. Each channel has a power-of-two
+// ring sized in prepareToPlay for maxDelayMs, read with a linearly
+// interpolated fractional delay. A one-pole low-pass in the feedback path
+// darkens each repeat.
+//
+// While time, feedback and mix are steady, a block is processed in chunks no
+// longer than the delay, so every read in a chunk lies behind every write and
+// the reads, writes and mix become vector operations. While any of them is
+// gliding, the chunk goes sample by sample instead.
 class DelayData
 {
 public:
+    static constexpr float maxDelayMs = 2000.0f;
+    static constexpr int maxChannels = 2;
+
+    void prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels);
+    void setParams (const float timeMs, const float feedbackAmount, const float mixAmount);
+    void process (juce::AudioBuffer<float>& buffer, const int numSamples);
+    void reset();
 
 private:
-    juce::dsp::DelayLine<float> delayLine;
-    
-    
-    
+    static constexpr int chunkSize = 256;
+    static constexpr float feedbackCutoff = 6000.0f;
+    static constexpr double smoothingSeconds = 0.05;
+
+    void processSteady (float* const* channels, const int numChannels, const int start, const int numSamples);
+    void processGliding (float* const* channels, const int numChannels, const int start, const int numSamples);
+
+    double sampleRate { 44100.0 };
+    int size { 0 };
+    int mask { 0 };
+    int writeIndex { 0 };
+    float maxDelaySamples { 1.0f };
+    float dampingCoefficient { 1.0f };
+    bool snapToTarget { true };
+
+    // size + 1 samples each: the last mirrors the first, so an interpolated
+    // read never has to wrap in the middle of a vector
+    std::array<juce::HeapBlock<float>, maxChannels> lines;
+    std::array<float, maxChannels> dampingState {};
+
+    juce::SmoothedValue<float> delaySamples;
+    juce::SmoothedValue<float> feedback;
+    juce::SmoothedValue<float> mix;
+
+    alignas (32) float delayed[chunkSize];
+    alignas (32) float damped[chunkSize];
+    alignas (32) float delayRamp[chunkSize];
+    alignas (32) float feedbackRamp[chunkSize];
+    alignas (32) float mixRamp[chunkSize];
 };
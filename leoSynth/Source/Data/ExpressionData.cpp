@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    ExpressionData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "ExpressionData.h"
+
+float ExpressionData::bendToSemitones (int pitchWheelValue, float range) noexcept
+{
+    // 8192 is the centre; the two halves are one step apart in size
+    const auto offset = pitchWheelValue - 8192;
+    return range * (float) offset / (offset < 0 ? 8192.0f : 8191.0f);
+}
+
+float ExpressionData::smoothingCoefficient (double sampleRate, int samplesPerTick)
+{
+    constexpr double timeConstantSeconds = 0.005;
+    return (float) (1.0 - std::exp (-(double) samplesPerTick / (timeConstantSeconds * sampleRate)));
+}
+
+void ExpressionData::snap (float masterBend) noexcept
+{
+    current = target;
+    current.bend += masterBend;
+}
+
+void ExpressionData::tick (float coefficient, float masterBend) noexcept
+{
+    current.bend += (target.bend + masterBend - current.bend) * coefficient;
+    current.pressure += (target.pressure - current.pressure) * coefficient;
+    current.timbre += (target.timbre - current.timbre) * coefficient;
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    ExpressionData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Per-note expression: pitch bend, pressure and timbre, as MPE sends them on a
+// note's own channel (or, outside MPE, on the channel it shares). A message
+// only stores a target, so a dense stream costs a few stores per voice; tick()
+// moves the values towards their targets once per control tick, and the voice
+// folds them into its modulation there. The bend glides towards the note's own
+// bend plus the channel-wide one it is given, so both move smoothly.
+class ExpressionData
+{
+public:
+    // 14-bit pitch wheel to semitones, for a bend range of +-range
+    static float bendToSemitones (int pitchWheelValue, float range) noexcept;
+
+    // Pressure is unipolar 0..1; timbre (CC74) is bipolar with 64 at 0
+    static float pressureFromMidi (int value) noexcept { return (float) value / 127.0f; }
+    static float timbreFromMidi (int value) noexcept { return (float) (value - 64) / 64.0f; }
+
+    // The per-tick step towards a target, for a time constant of about 5 ms
+    static float smoothingCoefficient (double sampleRate, int samplesPerTick);
+
+    void setPitchBend (float semitones) noexcept { target.bend = semitones; }
+    void setPressure (float value) noexcept { target.pressure = value; }
+    void setTimbre (float value) noexcept { target.timbre = value; }
+
+    // Jumps straight to the targets, for the first tick of a note
+    void snap (float masterBend) noexcept;
+    void tick (float coefficient, float masterBend) noexcept;
+    void reset() noexcept { current = target = {}; }
+
+    float getPitchBend() const noexcept { return current.bend; }
+    float getPressure() const noexcept { return current.pressure; }
+    float getTimbre() const noexcept { return current.timbre; }
+
+private:
+    struct Values
+    {
+        float bend { 0.0f };
+        float pressure { 0.0f };
+        float timbre { 0.0f };
+    };
+
+    Values current, target;
+};
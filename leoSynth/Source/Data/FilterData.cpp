@@ -8,67 +8,134 @@
 */
 #include "FilterData.h"
 
-FilterData::FilterData()
+namespace
 {
-    setType (juce::dsp::StateVariableTPTFilterType::lowpass);
+    constexpr float maxNormalisedFrequency = 0.49f;
+
+    struct PrewarpTable
+    {
+        static constexpr int size = 4096;
+
+        PrewarpTable()
+        {
+            for (int i = 0; i <= size; ++i)
+                values[(size_t) i] = std::tan (juce::MathConstants<float>::pi * maxNormalisedFrequency * (float) i / (float) size);
+        }
+
+        std::array<float, size + 1> values;
+    };
 }
 
-void FilterData::setParams (const int filterType, const float filterCutoff, const float filterResonance, const float modulator)
+float FilterData::prewarp (const float normalisedFrequency)
 {
-    selectFilterType (filterType);
-    float modFreq = filterCutoff * modulator;
-    modFreq = std::fmin(std::fmax(modFreq, 20.0f), 20000.0f);
-       
-    setCutoffFrequency (modFreq);
-    setResonance (filterResonance);
+    static const PrewarpTable table;
+
+    const auto position = juce::jlimit (0.0f, 1.0f, normalisedFrequency / maxNormalisedFrequency) * (float) PrewarpTable::size;
+    const auto index = juce::jmin ((int) position, PrewarpTable::size - 1);
+    const auto frac = position - (float) index;
+    const auto a = table.values[(size_t) index];
+
+    return a + frac * (table.values[(size_t) index + 1] - a);
 }
 
-void FilterData::prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels)
+void FilterData::setParams (const int newFilterType, const float filterCutoff, const float filterResonance)
 {
-    resetAll();
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = outputChannels;
-    prepare (spec);
+    filterType = newFilterType;
+    cutoff = filterCutoff;
+    resonance = filterResonance;
 }
 
-
-void FilterData::selectFilterType (const int filterType)
+void FilterData::setModulation (const float modulator, const int rampSamples, const float resonanceOffset)
 {
-    switch (filterType)
+    const auto modFreq = std::fmin (std::fmax (cutoff * modulator, 20.0f), 20000.0f);
+    const auto target = prewarp (modFreq / (float) sampleRate);
+    const auto r2Target = 1.0f / juce::jlimit (1.0f, 10.0f, resonance + resonanceOffset);
+
+    if (snapToTarget || rampSamples <= 0)
     {
-        case 0:
-            setType (juce::dsp::StateVariableTPTFilterType::lowpass);
-            break;
-            
-        case 1:
-            setType (juce::dsp::StateVariableTPTFilterType::bandpass);
-            break;
-            
-        case 2:
-            setType (juce::dsp::StateVariableTPTFilterType::highpass);
-            break;
-            
-        default:
-            setType (juce::dsp::StateVariableTPTFilterType::lowpass);
-            break;
+        g = target;
+        gStep = 0.0f;
+        r2 = r2Target;
+        r2Step = 0.0f;
+        rampRemaining = 0;
+        snapToTarget = false;
+        return;
     }
+
+    gStep = (target - g) / (float) rampSamples;
+    r2Step = (r2Target - r2) / (float) rampSamples;
+    rampRemaining = rampSamples;
+}
+
+void FilterData::prepareToPlay (double newSampleRate, int samplesPerBlock, int outputChannels)
+{
+    juce::ignoreUnused (samplesPerBlock, outputChannels);
+    sampleRate = newSampleRate;
+    prewarp (0.0f);   // builds the shared table here rather than on the audio thread
+    resetAll();
 }
 
-void FilterData::processNextBlock(juce::AudioBuffer<float>& buffer)
+void FilterData::process (juce::AudioBuffer<float>& buffer, const int startSample, const int numSamples)
 {
-    juce::dsp::AudioBlock<float> block { buffer };
-    process (juce::dsp::ProcessContextReplacing<float>(block));
+    jassert (buffer.getNumChannels() <= maxChannels);
+
+    float* channels[maxChannels] {};
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), maxChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = buffer.getWritePointer (ch, startSample);
+
+    switch (filterType)
+    {
+        case 1:  processChannels<1> (channels, numChannels, numSamples); break;
+        case 2:  processChannels<2> (channels, numChannels, numSamples); break;
+        default: processChannels<0> (channels, numChannels, numSamples); break;
+    }
 }
 
-float FilterData::processNextSample (int channel, float inputValue)
+template <int FilterType>
+void FilterData::processChannels (float* const* channels, const int numChannels, const int numSamples)
 {
-    return processSample (channel, inputValue);
+    auto s1 = Vec::fromRawArray (state1);
+    auto s2 = Vec::fromRawArray (state2);
+    alignas (64) float frame[maxChannels] {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (rampRemaining > 0)
+        {
+            g += gStep;
+            r2 += r2Step;
+            --rampRemaining;
+        }
+
+        const auto h = 1.0f / (1.0f + r2 * g + g * g);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            frame[ch] = channels[ch][i];
+
+        const auto yHP = (Vec::fromRawArray (frame) - s1 * (g + r2) - s2) * h;
+        const auto yBP = yHP * g + s1;
+        s1 = yHP * g + yBP;
+        const auto yLP = yBP * g + s2;
+        s2 = yBP * g + yLP;
+
+        if (FilterType == 0)       yLP.copyToRawArray (frame);
+        else if (FilterType == 1)  yBP.copyToRawArray (frame);
+        else                       yHP.copyToRawArray (frame);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch][i] = frame[ch];
+    }
+
+    s1.copyToRawArray (state1);
+    s2.copyToRawArray (state2);
 }
 
 void FilterData::resetAll()
 {
-    reset();
-    lfo.reset();
+    std::fill (std::begin (state1), std::end (state1), 0.0f);
+    std::fill (std::begin (state2), std::end (state2), 0.0f);
+    rampRemaining = 0;
+    snapToTarget = true;
 }
@@ -11,17 +11,100 @@
 #include "OscData.h"
 #include <JuceHeader.h>
 
-class FilterData : public juce::dsp::StateVariableTPTFilter<float>
+// TPT state variable filter (same topology as juce::dsp::StateVariableTPTFilter)
+// with a control-rate cutoff. The modulator is sampled once every
+// controlInterval samples and the filter glides linearly to the new cutoff over
+// the next tick. The ramp carries across process() calls, so a sweep does not
+// depend on the host block size. The tan() prewarp comes from a shared table.
+//
+// One FilterData serves every channel of a voice: the channels sit in the lanes
+// of one SIMD register, so the coefficients are worked out once per sample.
+class FilterData
 {
 public:
-    FilterData();
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int controlInterval = 32;
+    static constexpr int maxChannels = (int) Vec::SIMDNumElements;
+
     void prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels);
-    void setParams (const int filterType, const float filterCutoff, const float filterResonance, const float modulator);
-    void processNextBlock (juce::AudioBuffer<float>& buffer);
-    float processNextSample (int channel, float inputValue);
+    void setParams (const int filterType, const float filterCutoff, const float filterResonance);
+
+    // Glide to filterCutoff * modulator, and filterResonance + resonanceOffset,
+    // over the next rampSamples samples; the first call after resetAll() jumps
+    // there instead
+    void setModulation (const float modulator, const int rampSamples, const float resonanceOffset = 0.0f);
+
+    // Filters every channel of the buffer in place, up to maxChannels
+    void process (juce::AudioBuffer<float>& buffer, const int startSample, const int numSamples);
+
+    // One channel, with the input computed inline: output[i] is input (i)
+    // filtered, so a voice can mix, scale and filter a sample in one go
+    template <typename Input>
+    void processMono (Input&& input, float* output, const int numSamples)
+    {
+        switch (filterType)
+        {
+            case 1:  processMonoSamples<1> (input, output, numSamples); break;
+            case 2:  processMonoSamples<2> (input, output, numSamples); break;
+            default: processMonoSamples<0> (input, output, numSamples); break;
+        }
+    }
+
     void resetAll();
-    
+
+    // tan (pi * normalisedFrequency), normalisedFrequency in [0, 0.49]
+    static float prewarp (const float normalisedFrequency);
+
 private:
-    void selectFilterType (const int type);
-    juce::dsp::Oscillator<float> lfo { [](float x) { return std::sin (x); }};
+    template <int FilterType>
+    void processChannels (float* const* channels, const int numChannels, const int numSamples);
+
+    // Same arithmetic as processChannels, on lane 0 of the state
+    template <int FilterType, typename Input>
+    void processMonoSamples (Input& input, float* output, const int numSamples)
+    {
+        auto s1 = state1[0];
+        auto s2 = state2[0];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (rampRemaining > 0)
+            {
+                g += gStep;
+                r2 += r2Step;
+                --rampRemaining;
+            }
+
+            const auto h = 1.0f / (1.0f + r2 * g + g * g);
+            const auto yHP = (input (i) - s1 * (g + r2) - s2) * h;
+            const auto yBP = yHP * g + s1;
+            s1 = yHP * g + yBP;
+            const auto yLP = yBP * g + s2;
+            s2 = yBP * g + yLP;
+
+            if (FilterType == 0)       output[i] = yLP;
+            else if (FilterType == 1)  output[i] = yBP;
+            else                       output[i] = yHP;
+        }
+
+        state1[0] = s1;
+        state2[0] = s2;
+    }
+
+    int filterType { 0 };
+    float cutoff { 200.0f };
+    float resonance { 1.0f };
+    double sampleRate { 44100.0 };
+
+    float g { 0.0f };
+    float gStep { 0.0f };
+    float r2 { 1.0f };
+    float r2Step { 0.0f };
+    int rampRemaining { 0 };
+    bool snapToTarget { true };
+
+    // Integrator state, one lane per channel
+    alignas (64) float state1[maxChannels] {};
+    alignas (64) float state2[maxChannels] {};
 };
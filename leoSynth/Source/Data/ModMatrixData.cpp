@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ModMatrixData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "ModMatrixData.h"
+
+void ModMatrixData::setSlot (int slot, int source, int destination, float amount)
+{
+    jassert (slot >= 0 && slot < numSlots);
+    slots[(size_t) slot] = { juce::jlimit (0, numSources - 1, source), juce::jlimit (0, numDestinations - 1, destination), amount };
+    compile();
+}
+
+void ModMatrixData::compile()
+{
+    numRoutes = 0;
+    targetMask = 0;
+
+    for (const auto& slot : slots)
+    {
+        if (slot.source == noSource || slot.destination == noDestination || slot.amount == 0.0f)
+            continue;
+
+        routes[(size_t) numRoutes++] = slot;
+        targetMask |= 1u << slot.destination;
+    }
+}
+
+//==============================================================================
+float ModMatrixData::lfo (int shape, float phase)
+{
+    switch (shape)
+    {
+        case triangle:  return 1.0f - 4.0f * std::abs (phase - 0.5f);
+        case saw:       return 2.0f * phase - 1.0f;
+        case square:    return phase < 0.5f ? 1.0f : -1.0f;
+        default:        return std::sin (juce::MathConstants<float>::twoPi * phase);
+    }
+}
+
+void ModMatrixData::setVoiceLfo (int shape, float rateHz)
+{
+    voiceLfoShape = shape;
+    voiceLfoRate = rateHz;
+}
+
+void ModMatrixData::setGlobalLfo (int shape, float rateHz)
+{
+    globalLfoShape = shape;
+    globalLfoRate = rateHz;
+}
+
+void ModMatrixData::setSampleRate (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+void ModMatrixData::advanceClock (int numSamples)
+{
+    const auto phase = globalLfoPhase + globalLfoRate * (float) (numSamples / sampleRate);
+    globalLfoPhase = phase - std::floor (phase);
+    clock += numSamples;
+}
+
+float ModMatrixData::getGlobalLfo (juce::int64 sampleTime) const
+{
+    // Voices only ask for times inside the block being rendered
+    const auto phase = globalLfoPhase + globalLfoRate * (float) ((double) (sampleTime - clock) / sampleRate);
+    return lfo (globalLfoShape, phase - std::floor (phase));
+}
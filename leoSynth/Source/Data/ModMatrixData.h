@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    ModMatrixData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Routes modulation sources to voice destinations. The routing slots are
+// compiled into a flat array of the ones that actually do something, so an
+// empty slot costs nothing. Voices evaluate it once per control tick, one voice
+// at a time (float) or a SIMD register of voices at once, and ramp the results
+// across the tick: the per-sample cost is the same however many slots are used.
+//
+// It also carries the sources shared by every voice: the mod wheel, the
+// channel-wide pitch bend (the MPE master channel's) and the global LFO, which
+// runs on the owner's sample clock so voices rendering at different moments
+// still read the same phase. Pressure and timbre are per-note sources the
+// voices fill in from their own expression.
+class ModMatrixData
+{
+public:
+    enum Source { noSource, ampEnvelope, modEnvelope, voiceLfo, globalLfo, velocity, key, modWheel, pressure, timbre, numSources };
+    enum Destination { noDestination, cutoff, resonance, pitch, fmDepth, gain, numDestinations };
+    enum LfoShape { sine, triangle, saw, square };
+
+    static constexpr int numSlots = 4;
+
+    static juce::StringArray getSourceNames() { return { "None", "Amp Env", "Mod Env", "LFO 1", "LFO 2", "Velocity", "Key", "Mod Wheel", "Pressure", "Timbre" }; }
+    static juce::StringArray getDestinationNames() { return { "None", "Cutoff", "Resonance", "Pitch", "FM Depth", "Gain" }; }
+    static juce::StringArray getLfoShapeNames() { return { "Sine", "Triangle", "Saw", "Square" }; }
+
+    void setSlot (int slot, int source, int destination, float amount);
+    bool isEmpty() const noexcept { return numRoutes == 0; }
+    bool targets (Destination destination) const noexcept { return (targetMask >> destination) & 1; }
+
+    // Adds every route's source * amount to its destination. T is float for one
+    // voice or a SIMDRegister holding one voice per lane
+    template <typename T>
+    void process (const T* sources, T* destinations) const
+    {
+        for (int i = 0; i < numRoutes; ++i)
+            destinations[routes[i].destination] += sources[routes[i].source] * routes[i].amount;
+    }
+
+    // What a destination's summed modulation does to the parameter
+    static float cutoffScale (float modulation)       { return std::exp2 (modulation * 4.0f); }     // +-4 octaves
+    static float resonanceOffset (float modulation)   { return modulation * 9.0f; }                // full range
+    static float pitchRatio (float modulation)        { return std::exp2 (modulation * 2.0f); }     // +-24 semitones
+    static float fmDepthScale (float modulation)      { return juce::jmax (0.0f, 1.0f + modulation); }
+    static float gainScale (float modulation)         { return juce::jmax (0.0f, 1.0f + modulation); }
+
+    // LFOs, bipolar, phase in [0, 1)
+    static float lfo (int shape, float phase);
+    void setVoiceLfo (int shape, float rateHz);
+    void setGlobalLfo (int shape, float rateHz);
+    int getVoiceLfoShape() const noexcept { return voiceLfoShape; }
+    float getVoiceLfoRate() const noexcept { return voiceLfoRate; }
+
+    // Shared sources; advanceClock is called once the owner has rendered a block
+    void setSampleRate (double newSampleRate);
+    void advanceClock (int numSamples);
+    juce::int64 getClock() const noexcept { return clock; }
+    float getGlobalLfo (juce::int64 sampleTime) const;
+    void setModWheel (float value) noexcept { modWheelValue = value; }
+    float getModWheel() const noexcept { return modWheelValue; }
+    void setMasterPitchBend (float semitones) noexcept { masterPitchBend = semitones; }
+    float getMasterPitchBend() const noexcept { return masterPitchBend; }
+
+private:
+    void compile();
+
+    struct Slot
+    {
+        int source { noSource };
+        int destination { noDestination };
+        float amount { 0.0f };
+    };
+
+    std::array<Slot, numSlots> slots;
+    std::array<Slot, numSlots> routes;
+    int numRoutes { 0 };
+    juce::uint32 targetMask { 0 };
+
+    int voiceLfoShape { sine };
+    float voiceLfoRate { 2.0f };
+    int globalLfoShape { sine };
+    float globalLfoRate { 0.5f };
+    float globalLfoPhase { 0.0f };
+    double sampleRate { 44100.0 };
+    juce::int64 clock { 0 };
+    float modWheelValue { 0.0f };
+    float masterPitchBend { 0.0f };
+};
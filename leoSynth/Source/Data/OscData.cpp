@@ -9,84 +9,269 @@
 
 #include "OscData.h"
 
-void OscData::prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels)
+float OscData::unisonRatio (const int index, const int numVoices, const float detuneCents)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = outputChannels;
-    prepare (spec);
-    fmOsc.prepare (spec);
+    if (numVoices <= 1)
+        return 1.0f;
+
+    const auto position = 2.0f * (float) index / (float) (numVoices - 1) - 1.0f;
+    return std::exp2 (position * detuneCents / 1200.0f);
+}
+
+float OscData::unisonLevel (const int index, const int numVoices, const float blend)
+{
+    if (numVoices <= 1)
+        return 1.0f;
+
+    // Detuned copies are roughly uncorrelated, so their powers add
+    const auto numCentre = numVoices % 2 == 1 ? 1 : 2;
+    const auto isCentre = std::abs (2 * index - (numVoices - 1)) < numCentre;
+    const auto power = (float) numCentre + (float) (numVoices - numCentre) * blend * blend;
+    return (isCentre ? 1.0f : blend) / std::sqrt (power);
+}
+
+void OscData::prepareToPlay (double newSampleRate, int samplesPerBlock, int outputChannels)
+{
+    juce::ignoreUnused (samplesPerBlock, outputChannels);
+    sampleRate = newSampleRate;
+    updateIncrements();
+    reset();
+}
+
+void OscData::reset()
+{
+    phase = 0.0f;
+    fmPhase = 0.0f;
+    level = targetLevel;
 }
 
 void OscData::setWaveType (const int choice)
 {
-    switch (choice)
-    {
-        case 0:
-            // Sine
-            initialise ([](float x) { return std::sin (x); });
-            break;
-            
-        case 1:
-            // Saw wave
-            initialise ([](float x) { return x / juce::MathConstants<float>::pi; });
-            break;
-            
-        case 2:
-            // Square wave
-            initialise ([](float x) { return x < 0.0f ? -1.0f : 1.0f; });
-            break;
-            
-        default:
-            jassertfalse;   // You're not supposed to be here!
-            break;
-    }
+    // Sine, Saw or Square: the tables are shared, so this only swaps pointers
+    jassert (choice >= 0 && choice < WavetableData::numWaveTypes);
+    wavetable = &WavetableData::get (choice);
+    updateTable (increment, fmDeviation);
 }
 
+void OscData::updateTable (const float carrierIncrement, const float deviation)
+{
+    // Band-limit for the highest frequency the stack's top voice can reach
+    table = wavetable->getTable (carrierIncrement * unisonMaxRatio + deviation);
+}
 
-float OscData::processNextSample (float input)
+void OscData::setUnison (const int numVoices, const float detuneCents, const float blend, const float phaseRandomness)
 {
-    fmMod = fmOsc.processSample (input) * fmDepth;
-    return gain.processSample (processSample (input));
+    numUnison = juce::jlimit (1, maxUnison, numVoices);
+    unisonPhaseRandomness = phaseRandomness;
+
+    for (int i = 0; i < maxUnison; ++i)
+    {
+        unisonRatios[i] = i < numUnison ? unisonRatio (i, numUnison, detuneCents) : 1.0f;
+        unisonLevels[i] = i < numUnison ? unisonLevel (i, numUnison, blend) : 0.0f;
+    }
+
+    unisonMaxRatio = unisonRatios[numUnison - 1];
+    updateTable (increment * incrementScale, fmDeviation * deviationScale);
 }
 
-void OscData::setWaveFrequency (const int midiNoteNumber)
+void OscData::retriggerUnison()
 {
-    setFrequency (juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber) + fmMod);
-    lastMidiNote = midiNoteNumber;
+    if (numUnison == 1)
+        return;
+
+    for (int i = 0; i < maxUnison; ++i)
+        unisonPhases[i] = wrapPhase (phase + unisonPhaseRandomness * random.nextFloat());
 }
 
-void OscData::getNextAudioBlock (juce::dsp::AudioBlock<float>& block)
+void OscData::renderUnison (const float* carrierIncrement, float* carrier, const int numSamples)
 {
-    processFmOsc (block);
-    process (juce::dsp::ProcessContextReplacing<float> (block));
+    // Every voice follows the carrier's increment, FM and pitch glide
+    // included, scaled by its detune ratio, so its phase at sample i is its
+    // start phase plus ratio times the increments summed up to i. With that
+    // running sum the samples no longer depend on each other: a register
+    // holds consecutive samples and sums the whole stack before it is stored.
+    // The loop still runs once per copy, so the cost grows with numUnison.
+    alignas (64) float travelled[kernelSize];
+    const auto numPadded = (numSamples + unisonWidth - 1) / unisonWidth * unisonWidth;
+    jassert (numPadded <= kernelSize);
+
+    auto total = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        travelled[i] = total;
+        total += carrierIncrement[i];
+    }
+
+    for (int i = numSamples; i < numPadded; ++i)
+        travelled[i] = total;
+
+    for (int i = 0; i < numPadded; i += unisonWidth)
+    {
+        const auto distance = Vec::fromRawArray (travelled + i);
+        auto sum = Vec::expand (0.0f);
+
+        for (int v = 0; v < numUnison; ++v)
+        {
+            const auto p = wrapPhase (Vec::expand (unisonPhases[v]) + distance * unisonRatios[v]);
+            sum = sum + WavetableData::lookup (table, p) * unisonLevels[v];
+        }
+
+        sum.copyToRawArray (carrier + i);
+    }
+
+    for (int v = 0; v < numUnison; ++v)
+        unisonPhases[v] = wrapPhase (unisonPhases[v] + total * unisonRatios[v]);
 }
 
-void OscData::processFmOsc (juce::dsp::AudioBlock<float>& block)
+void OscData::renderNextBlock (float* output, const int numSamples)
 {
-    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+    alignas (64) float carrier[kernelSize];
+    float carrierIncrement[kernelSize];
+    float modulator[kernelSize];
+
+    for (int start = 0; start < numSamples; start += kernelSize)
     {
-        for (int s = 0; s < block.getNumSamples(); ++s)
+        const auto n = juce::jmin (kernelSize, numSamples - start);
+        const auto modulated = rampRemaining > 0 || incrementScale != 1.0f || deviationScale != 1.0f;
+
+        if (fmDeviation == 0.0f)
         {
-            fmMod = fmOsc.processSample (block.getSample (ch, s)) * fmDepth;
+            juce::FloatVectorOperations::clear (modulator, n);
+        }
+        else
+        {
+            // The modulator is a plain ramp, so its phases and its sine are
+            // computed for the whole chunk in loops the compiler vectorises.
+            // In ratio mode it follows the carrier's pitch modulation
+            const auto modIncrement = fmMode == ratioFm ? fmIncrement * incrementScale : fmIncrement;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto modPhase = fmPhase + (float) i * modIncrement;
+                modulator[i] = modPhase - (float) (int) modPhase;
+            }
+
+            for (int i = 0; i < n; ++i)
+                modulator[i] = fastSine (modulator[i]);
+
+            fmPhase = wrapPhase (fmPhase + (float) n * modIncrement);
+        }
+
+        if (! modulated)
+        {
+            for (int i = 0; i < n; ++i)
+                carrierIncrement[i] = increment + fmDeviation * modulator[i];
+        }
+        else
+        {
+            const auto rampLength = juce::jmin (n, rampRemaining);
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto steps = (float) juce::jmin (i + 1, rampLength);
+                carrierIncrement[i] = increment * (incrementScale + incrementScaleStep * steps)
+                                       + fmDeviation * (deviationScale + deviationScaleStep * steps) * modulator[i];
+            }
+
+            incrementScale += incrementScaleStep * (float) rampLength;
+            deviationScale += deviationScaleStep * (float) rampLength;
+            rampRemaining -= rampLength;
+        }
+
+        // The carrier phase is a running sum and stays serial
+        if (numUnison > 1)
+        {
+            renderUnison (carrierIncrement, carrier, n);
+        }
+        else
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                carrier[i] = WavetableData::lookup (table, phase);
+                phase = wrapPhase (phase + carrierIncrement[i]);
+            }
+        }
+
+        // A new level glides in over one chunk; otherwise it is a plain scale
+        if (level != targetLevel)
+        {
+            const auto step = (targetLevel - level) / (float) n;
+
+            for (int i = 0; i < n; ++i)
+                output[start + i] += carrier[i] * (level + step * (float) (i + 1));
+
+            level = targetLevel;
+        }
+        else
+        {
+            juce::FloatVectorOperations::addWithMultiply (output + start, carrier, level, n);
         }
     }
 }
+
+void OscData::setWaveFrequency (const int midiNoteNumber)
+{
+    noteFrequency = (float) juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber);
+    updateIncrements();
+}
+
 void OscData::setGain (const float levelInDecibels)
 {
-    gain.setGainDecibels (levelInDecibels);
+    targetLevel = juce::Decibels::decibelsToGain (levelInDecibels);
 }
-void OscData::updateFm (const float freq, const float depth)
+void OscData::updateFm (const int mode, const float freq, const float depth)
 {
-    fmOsc.setFrequency (freq);
+    fmMode = mode;
+    fmAmount = freq;
     fmDepth = depth;
-    auto currentFreq = juce::MidiMessage::getMidiNoteInHertz (lastMidiNote) + fmMod;
-    setFrequency (currentFreq >= 0 ? currentFreq : currentFreq * -1.0f);
+    updateIncrements();
+}
+
+void OscData::setModulation (const float pitchRatio, const float fmDepthScale, const int rampSamples)
+{
+    if (snapModulation || rampSamples <= 0)
+    {
+        incrementScale = pitchRatio;
+        deviationScale = fmDepthScale;
+        incrementScaleStep = deviationScaleStep = 0.0f;
+        rampRemaining = 0;
+        snapModulation = false;
+    }
+    else
+    {
+        incrementScaleStep = (pitchRatio - incrementScale) / (float) rampSamples;
+        deviationScaleStep = (fmDepthScale - deviationScale) / (float) rampSamples;
+        rampRemaining = rampSamples;
+    }
+
+    // Band-limit for where the ramp ends up
+    updateTable (juce::jmin (increment * pitchRatio, 0.5f), fmDeviation * fmDepthScale);
+}
+
+void OscData::resetModulation()
+{
+    incrementScale = deviationScale = 1.0f;
+    incrementScaleStep = deviationScaleStep = 0.0f;
+    rampRemaining = 0;
+    snapModulation = true;
 }
 
 void OscData::setPitch(int pitch)
 {
-    auto toAddFreq = juce::MidiMessage::getMidiNoteInHertz(pitch);
-    setFrequency (juce::MidiMessage::getMidiNoteInHertz (lastMidiNote) + fmMod + toAddFreq);
+    pitchOffset = (float) juce::MidiMessage::getMidiNoteInHertz (pitch);
+    updateIncrements();
+}
+
+void OscData::updateIncrements()
+{
+    const auto carrierFrequency = std::abs (noteFrequency + pitchOffset);
+    const auto modulatorFrequency = fmMode == ratioFm ? carrierFrequency * fmAmount : fmAmount;
+    const auto deviation = fmMode == ratioFm ? carrierFrequency * fmDepth * 0.01f : fmDepth;
+
+    increment = juce::jmin ((float) (carrierFrequency / sampleRate), 0.5f);
+    fmIncrement = juce::jmin ((float) (modulatorFrequency / sampleRate), 0.5f);
+    fmDeviation = (float) (deviation / sampleRate);
+
+    updateTable (increment, fmDeviation);
 }
@@ -9,25 +9,138 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "WavetableData.h"
 
 
-class OscData : public juce::dsp::Oscillator<float>
+// Wavetable carrier with a sine FM operator. The modulator drives the carrier
+// increment every sample, i.e. true frequency modulation: the carrier phase is
+// the running sum of the modulated increment, which for a sine modulator is
+// phase modulation by its integral, so the spectra are the classic FM ones
+// with the depth read as frequency deviation. In fixed mode the FM frequency and depth are in Hz.
+// In ratio mode the frequency is a multiple of the carrier, and the depth is a
+// percentage of the carrier frequency, so the timbre holds across the keyboard.
+// The mod matrix scales the pitch and the FM depth at control rate; like
+// FilterData's cutoff, both glide to their new values over the next tick.
+//
+// Unison stacks up to maxUnison copies of the carrier, detuned evenly across
+// +-detune cents and sharing the FM operator. The stack renders a SIMD
+// register of consecutive samples at a time, reading the same tables as the
+// single carrier, so a stack of one sounds like it. A single voice keeps the
+// scalar path. Every copy still reads the table once per sample, so a stack
+// costs numUnison / register width register lookups per sample, each gathered
+// lane by lane: eight copies take roughly twice a single oscillator with SSE.
+class OscData
 {
 public:
+    enum FmMode { fixedFm, ratioFm };
+
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // Wraps into [0, 1); the carrier can run backwards under deep FM. A tiny
+    // negative phase rounds up to exactly 1, which would read past the table
+    static float wrapPhase (float phase) noexcept
+    {
+        phase -= std::floor (phase);
+        return phase >= 1.0f ? phase - 1.0f : phase;
+    }
+
+    static Vec wrapPhase (Vec phase) noexcept
+    {
+        const auto one = Vec::expand (1.0f);
+        phase = phase - Vec::truncate (phase);
+        phase = phase + (one & Vec::lessThan (phase, Vec::expand (0.0f)));
+        return phase - (one & Vec::greaterThanOrEqual (phase, one));
+    }
+
+    // Parabolic sine with one refinement step (about 0.1% error), phase in [0, 1)
+    static float fastSine (const float phase) noexcept
+    {
+        const auto x = phase - 0.5f;
+        auto y = x * 8.0f - x * std::abs (x) * 16.0f;
+        y = (y * std::abs (y) - y) * 0.225f + y;
+        return -y;
+    }
+
+    static Vec fastSine (const Vec phase) noexcept
+    {
+        const auto x = phase - 0.5f;
+        auto y = x * 8.0f - x * Vec::abs (x) * 16.0f;
+        y = (y * Vec::abs (y) - y) * 0.225f + y;
+        return Vec::expand (0.0f) - y;
+    }
+
+    static constexpr int maxUnison = 16;
+
+    // Frequency ratio of voice index in a stack of numVoices, the outer
+    // voices detuneCents away from the note
+    static float unisonRatio (const int index, const int numVoices, const float detuneCents);
+
+    // Level of voice index: the middle voice (or pair) at 1 and the others at
+    // blend, scaled so the stack keeps the power of a single voice
+    static float unisonLevel (const int index, const int numVoices, const float blend);
+
     void prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels);
     void setWaveType (const int choice);
     void setGain (const float levelInDecibels);
     void setPitch(int pitch);
     void setWaveFrequency (const int midiNoteNumber);
-    void getNextAudioBlock (juce::dsp::AudioBlock<float>& block);
-    void updateFm (const float freq, const float depth);
-    float processNextSample(float input);
+    void updateFm (const int mode, const float freq, const float depth);
+
+    // phaseRandomness scatters the stack's phases at each note start, from all
+    // in phase (0) to anywhere in the cycle (1)
+    void setUnison (const int numVoices, const float detuneCents, const float blend, const float phaseRandomness);
+
+    // Called at note start to lay the stack's phases out again
+    void retriggerUnison();
+
+    // Glide to pitchRatio and fmDepthScale over the next rampSamples samples;
+    // the first call after resetModulation() jumps there instead
+    void setModulation (const float pitchRatio, const float fmDepthScale, const int rampSamples);
+    void resetModulation();
+    // Adds the oscillator, at its gain, to output
+    void renderNextBlock (float* output, const int numSamples);
+    void reset();
     
 private:
-    void processFmOsc (juce::dsp::AudioBlock<float>& block);
-    juce::dsp::Oscillator<float> fmOsc { [](float x) { return std::sin (x); } };
-    juce::dsp::Gain<float> gain;
-    float fmMod { 0.0f };
+    static constexpr int unisonWidth = (int) Vec::SIMDNumElements;
+
+    void updateIncrements();
+    void updateTable (const float carrierIncrement, const float deviation);
+    void renderUnison (const float* carrierIncrement, float* carrier, const int numSamples);
+
+    static constexpr int kernelSize = 64;
+    static_assert (kernelSize % unisonWidth == 0, "A kernel is a whole number of registers");
+
+    const WavetableData* wavetable { &WavetableData::get (WavetableData::sine) };
+    const float* table { wavetable->getTable (0.0f) };
+    float phase { 0.0f };
+    float increment { 0.0f };
+    float fmPhase { 0.0f };
+    float fmIncrement { 0.0f };
+    float fmDeviation { 0.0f };
+    float incrementScale { 1.0f };
+    float incrementScaleStep { 0.0f };
+    float deviationScale { 1.0f };
+    float deviationScaleStep { 0.0f };
+    int rampRemaining { 0 };
+    bool snapModulation { true };
+    double sampleRate { 44100.0 };
+
+    float level { 1.0f };
+    float targetLevel { 1.0f };
+    int fmMode { fixedFm };
+    float fmAmount { 0.0f };
     float fmDepth { 0.0f };
-    int lastMidiNote { 0 };
+    float noteFrequency { (float) juce::MidiMessage::getMidiNoteInHertz (0) };
+    float pitchOffset { 0.0f };
+
+    float unisonPhases[maxUnison] {};
+    float unisonRatios[maxUnison] {};
+    float unisonLevels[maxUnison] {};
+    int numUnison { 1 };
+    float unisonMaxRatio { 1.0f };
+    float unisonPhaseRandomness { 0.0f };
+
+    // Fixed seed, so an offline render of a session repeats exactly
+    juce::Random random { 0x5eed };
 };
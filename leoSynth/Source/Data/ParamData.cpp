@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    ParamData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "ParamData.h"
+#include "StateData.h"
+
+namespace
+{
+    // Must stay in the same order as ParamData::Id
+    const char* const paramIds[] =
+    {
+        "OSCWAVETYPE", "OSCFMFREQ", "OSCFMDEPTH", "OSCFMMODE", "OSCFMRATIO", "OSC1PITCH", "OSCGAIN",
+        "OSCUNISON", "OSCDETUNE", "OSCBLEND", "OSCPHASERAND",
+        "OSCWAVETYPE2", "OSCFMFREQ2", "OSCFMDEPTH2", "OSCFMMODE2", "OSCFMRATIO2", "OSC2PITCH", "OSCGAIN2",
+        "OSCUNISON2", "OSCDETUNE2", "OSCBLEND2", "OSCPHASERAND2",
+        "ATTACK", "DECAY", "SUSTAIN", "RELEASE", "ENVCURVE",
+        "MODATTACK", "MODDECAY", "MODSUSTAIN", "MODRELEASE", "MODENVCURVE",
+        "FILTERTYPE", "FILTERFREQ", "FILTERRES",
+        "PAN", "SPREAD", "DECORRELATION",
+        "DELAYTIME", "DELAYFEEDBACK", "DELAYMIX",
+        "VOICEENGINE", "POLYPHONY", "MULTICORE", "MULTICORETHRESHOLD", "OVERSAMPLING",
+        "MPE", "MPEBENDRANGE",
+        "LFO1SHAPE", "LFO1RATE", "LFO2SHAPE", "LFO2RATE",
+        "MOD1SRC", "MOD1DST", "MOD1AMT", "MOD2SRC", "MOD2DST", "MOD2AMT",
+        "MOD3SRC", "MOD3DST", "MOD3AMT", "MOD4SRC", "MOD4DST", "MOD4AMT"
+    };
+
+    static_assert (sizeof (paramIds) / sizeof (paramIds[0]) == ParamData::numParams, "paramIds out of sync with ParamData::Id");
+}
+
+ParamData::ParamData (juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < numParams; ++i)
+    {
+        rawValues[i] = apvts.getRawParameterValue (paramIds[i]);
+        jassert (rawValues[i] != nullptr);   // ID missing from createParams()
+        values[i] = rawValues[i]->load();
+    }
+
+   #if JUCE_DEBUG
+    // StateData finds saved parameters by ID hash alone, so no two may collide
+    for (int i = 0; i < numParams; ++i)
+        for (int j = i + 1; j < numParams; ++j)
+            jassert (StateData::hashId (paramIds[i]) != StateData::hashId (paramIds[j]));
+   #endif
+}
+
+ParamData::Mask ParamData::update()
+{
+    Mask changed = 0;
+
+    for (int i = 0; i < numParams; ++i)
+    {
+        const auto newValue = rawValues[i]->load (std::memory_order_relaxed);
+
+        if (forceUpdate || newValue != values[i])
+        {
+            values[i] = newValue;
+            changed |= Mask (1) << i;
+        }
+    }
+
+    forceUpdate = false;
+    return changed;
+}
+
+ParamData::Mask ParamData::setValues (const Values& newValues)
+{
+    Mask changed = 0;
+
+    for (int i = 0; i < numParams; ++i)
+    {
+        if (newValues[i] != values[i])
+        {
+            values[i] = newValues[i];
+            changed |= Mask (1) << i;
+        }
+    }
+
+    return changed;
+}
+
+const char* ParamData::getParamId (const Id id)
+{
+    return paramIds[id];
+}
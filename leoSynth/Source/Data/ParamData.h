@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    ParamData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Snapshot of every APVTS parameter, resolved once to raw atomic pointers so
+// the audio thread never does string lookups. update() is called once per
+// block and returns a bitmask of the parameters that moved since last time.
+class ParamData
+{
+public:
+    enum Id
+    {
+        oscWaveType,
+        oscFmFreq,
+        oscFmDepth,
+        oscFmMode,
+        oscFmRatio,
+        osc1Pitch,
+        oscGain,
+        oscUnison,
+        oscDetune,
+        oscBlend,
+        oscPhaseRandom,
+        oscWaveType2,
+        oscFmFreq2,
+        oscFmDepth2,
+        oscFmMode2,
+        oscFmRatio2,
+        osc2Pitch,
+        oscGain2,
+        oscUnison2,
+        oscDetune2,
+        oscBlend2,
+        oscPhaseRandom2,
+        attack,
+        decay,
+        sustain,
+        release,
+        envCurve,
+        modAttack,
+        modDecay,
+        modSustain,
+        modRelease,
+        modEnvCurve,
+        filterType,
+        filterFreq,
+        filterRes,
+        pan,
+        stereoSpread,
+        decorrelation,
+        delayTime,
+        delayFeedback,
+        delayMix,
+        voiceEngine,
+        polyphony,
+        multiCore,
+        multiCoreThreshold,
+        oversampling,
+        mpe,
+        mpeBendRange,
+        lfo1Shape,
+        lfo1Rate,
+        lfo2Shape,
+        lfo2Rate,
+        mod1Source,     // each slot is source, destination, amount
+        mod1Destination,
+        mod1Amount,
+        mod2Source,
+        mod2Destination,
+        mod2Amount,
+        mod3Source,
+        mod3Destination,
+        mod3Amount,
+        mod4Source,
+        mod4Destination,
+        mod4Amount,
+        numParams
+    };
+
+    using Mask = juce::uint64;
+    using Values = std::array<float, numParams>;
+    static_assert (numParams <= 64, "ParamData::Mask holds one bit per parameter");
+
+    explicit ParamData (juce::AudioProcessorValueTreeState& apvts);
+
+    Mask update();
+    void markAllDirty() { forceUpdate = true; }
+
+    // Replaces the snapshot with a preloaded block, e.g. a program from the
+    // bank, and returns what moved; update() keeps reading the APVTS after it
+    Mask setValues (const Values& newValues);
+
+    float get (const Id id) const { return values[id]; }
+    int getInt (const Id id) const { return (int) values[id]; }
+
+    static const char* getParamId (const Id id);
+    static constexpr Mask bit (const Id id) { return Mask (1) << id; }
+    static constexpr Mask bits (std::initializer_list<Id> ids)
+    {
+        Mask m = 0;
+        for (auto id : ids)
+            m |= bit (id);
+        return m;
+    }
+
+    static constexpr Mask osc1Mask()    { return bits ({ oscWaveType, oscFmFreq, oscFmDepth, oscFmMode, oscFmRatio, osc1Pitch, oscGain,
+                                                          oscUnison, oscDetune, oscBlend, oscPhaseRandom }); }
+    static constexpr Mask osc2Mask()    { return bits ({ oscWaveType2, oscFmFreq2, oscFmDepth2, oscFmMode2, oscFmRatio2, osc2Pitch, oscGain2,
+                                                          oscUnison2, oscDetune2, oscBlend2, oscPhaseRandom2 }); }
+    static constexpr Mask ampAdsrMask() { return bits ({ attack, decay, sustain, release, envCurve }); }
+    static constexpr Mask modAdsrMask() { return bits ({ modAttack, modDecay, modSustain, modRelease, modEnvCurve }); }
+    static constexpr Mask filterMask()  { return bits ({ filterType, filterFreq, filterRes }); }
+    static constexpr Mask stereoMask()  { return bits ({ pan, stereoSpread, decorrelation }); }
+    static constexpr Mask mpeMask()     { return bits ({ mpe, mpeBendRange }); }
+    static constexpr Mask delayMask()   { return bits ({ delayTime, delayFeedback, delayMix }); }
+    static constexpr Mask modMatrixMask()
+    {
+        Mask m = 0;
+        for (int id = lfo1Shape; id <= mod4Amount; ++id)
+            m |= bit ((Id) id);
+        return m;
+    }
+
+private:
+    std::array<std::atomic<float>*, numParams> rawValues;
+    Values values;
+    bool forceUpdate { true };
+};
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    StateData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "StateData.h"
+
+juce::uint32 StateData::hashId (const juce::String& paramId) noexcept
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = paramId.toRawUTF8(); *c != 0; ++c)
+    {
+        hash ^= (juce::uint8) *c;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void StateData::write (juce::AudioProcessor& processor, juce::MemoryBlock& destData)
+{
+    auto& parameters = processor.getParameters();
+    juce::MemoryOutputStream out (destData, false);
+
+    out.writeInt ((int) magic);
+    out.writeShort ((short) version);
+    out.writeShort ((short) parameters.size());
+
+    for (auto* parameter : parameters)
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+        jassert (ranged != nullptr);   // every parameter comes from createParams()
+
+        out.writeInt ((int) hashId (ranged->getParameterID()));
+        out.writeFloat (ranged->convertFrom0to1 (ranged->getValue()));
+    }
+}
+
+bool StateData::read (juce::AudioProcessor& processor, const void* data, int sizeInBytes, juce::Array<float>& values)
+{
+    auto& parameters = processor.getParameters();
+    juce::Array<juce::uint32> hashes;
+
+    values.clearQuick();
+
+    for (auto* parameter : parameters)
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+        jassert (ranged != nullptr);
+
+        hashes.add (hashId (ranged->getParameterID()));
+        values.add (ranged->convertFrom0to1 (ranged->getDefaultValue()));
+    }
+
+    return visitEntries (data, sizeInBytes, [&] (juce::uint32 hash, float value)
+    {
+        const auto index = hashes.indexOf (hash);
+
+        if (index >= 0)
+            values.set (index, value);
+    });
+}
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    StateData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Binary plugin state, all little-endian:
+//
+//   uint32  magic "LEOS"
+//   uint16  version
+//   uint16  number of entries
+//   then per entry: uint32 FNV-1a hash of the parameter ID, float plain value
+//
+// Values are stored in plain units, so they survive a range change. IDs the
+// reader does not know are skipped, and parameters missing from the state get
+// their defaults, so presets survive parameters being added or removed.
+class StateData
+{
+public:
+    static constexpr int version = 1;
+
+    static void write (juce::AudioProcessor& processor, juce::MemoryBlock& destData);
+
+    // Plain values in getParameters() order; false if this is not a state
+    // written by write(), or one from a newer version
+    static bool read (juce::AudioProcessor& processor, const void* data, int sizeInBytes, juce::Array<float>& values);
+
+    // Calls visit (idHash, plainValue) for every entry, without allocating;
+    // false if this is not a state written by write()
+    template <typename Visitor>
+    static bool visitEntries (const void* data, int sizeInBytes, Visitor&& visit);
+
+    static juce::uint32 hashId (const juce::String& paramId) noexcept;
+
+private:
+    static constexpr juce::uint32 magic = 0x534f454c;   // "LEOS" read as little-endian
+    static constexpr int headerSize = 8;
+    static constexpr int entrySize = 8;
+};
+
+template <typename Visitor>
+bool StateData::visitEntries (const void* data, int sizeInBytes, Visitor&& visit)
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    juce::MemoryInputStream in (data, (size_t) sizeInBytes, false);
+
+    if ((juce::uint32) in.readInt() != magic)
+        return false;
+
+    const auto stateVersion = (int) (juce::uint16) in.readShort();
+    const auto numEntries = (int) (juce::uint16) in.readShort();
+
+    if (stateVersion > version || sizeInBytes < headerSize + numEntries * entrySize)
+        return false;
+
+    for (int entry = 0; entry < numEntries; ++entry)
+    {
+        const auto hash = (juce::uint32) in.readInt();
+        visit (hash, in.readFloat());
+    }
+
+    return true;
+}
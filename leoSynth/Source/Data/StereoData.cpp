@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    StereoData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "StereoData.h"
+
+namespace
+{
+    // Low-discrepancy sequences over the note number: neighbouring notes land
+    // far apart, and no two notes in a chord share a place
+    inline float sequence (int midiNoteNumber, double step)
+    {
+        const auto x = (double) midiNoteNumber * step;
+        return (float) (x - std::floor (x));
+    }
+}
+
+float StereoData::spreadPosition (int midiNoteNumber)
+{
+    return sequence (midiNoteNumber, 0.6180339887) * 2.0f - 1.0f;
+}
+
+void StereoData::panGains (float position, float& left, float& right)
+{
+    const auto angle = (juce::jlimit (-1.0f, 1.0f, position) + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+    left = std::cos (angle) * juce::MathConstants<float>::sqrt2;
+    right = std::sin (angle) * juce::MathConstants<float>::sqrt2;
+}
+
+float StereoData::allpassCoefficient (int midiNoteNumber, float decorrelation)
+{
+    // The phase shift grows as the coefficient falls; half to full depth per note
+    return 1.0f - decorrelation * (0.5f + 0.5f * sequence (midiNoteNumber, 0.7548776662));
+}
+
+//==============================================================================
+void StereoData::setParams (float newPan, float newSpread, float newDecorrelation)
+{
+    pan = newPan;
+    spread = newSpread;
+    decorrelation = newDecorrelation;
+    updateTargets();
+}
+
+void StereoData::noteOn (int midiNoteNumber)
+{
+    note = midiNoteNumber;
+    updateTargets();
+    reset();
+}
+
+void StereoData::reset()
+{
+    leftGain = targetLeft;
+    rightGain = targetRight;
+    lastInput = lastOutput = 0.0f;
+}
+
+void StereoData::updateTargets()
+{
+    panGains (pan + spread * spreadPosition (note), targetLeft, targetRight);
+
+    const auto wasDecorrelating = isDecorrelating();
+    allpass = allpassCoefficient (note, decorrelation);
+
+    // The filter state is stale if it has been switched out
+    if (isDecorrelating() && ! wasDecorrelating)
+        lastInput = lastOutput = 0.0f;
+}
+
+void StereoData::decorrelate (const float* mono, float* right, int numSamples)
+{
+    // y[n] = a * x[n] + x[n - 1] - a * y[n - 1]
+    auto x1 = lastInput;
+    auto y1 = lastOutput;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto x = mono[i];
+        y1 = allpass * (x - y1) + x1;
+        x1 = x;
+        right[i] = y1;
+    }
+
+    lastInput = x1;
+    lastOutput = y1;
+}
+
+void StereoData::addTo (juce::AudioBuffer<float>& output, int startSample, const float* mono, int numSamples)
+{
+    jassert (output.getNumChannels() >= 2 && numSamples <= maxChunkSize);
+
+    const auto* left = mono;
+    const auto* right = mono;
+    alignas (64) float decorrelated[maxChunkSize];
+
+    if (isDecorrelating())
+    {
+        decorrelate (mono, decorrelated, numSamples);
+        right = decorrelated;
+    }
+
+    if (leftGain == targetLeft && rightGain == targetRight)
+    {
+        output.addFrom (0, startSample, left, numSamples, leftGain);
+        output.addFrom (1, startSample, right, numSamples, rightGain);
+        return;
+    }
+
+    output.addFromWithRamp (0, startSample, left, numSamples, leftGain, targetLeft);
+    output.addFromWithRamp (1, startSample, right, numSamples, rightGain, targetRight);
+    leftGain = targetLeft;
+    rightGain = targetRight;
+}
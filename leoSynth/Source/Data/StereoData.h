@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    StereoData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Turns a voice's mono output into stereo. Each voice sits at the master pan
+// plus its own place in the stereo spread, panned with an equal-power law that
+// leaves a centred voice at unity on both sides. Decorrelation runs the right
+// channel through a first-order allpass whose coefficient differs per note, so
+// stacked voices stop collapsing to the centre without changing their tone.
+//
+// The per-note values are fixed functions of the note number, so both voice
+// engines and every render of a session place a note in the same spot.
+class StereoData
+{
+public:
+    // Where the spread puts a note, in [-1, 1]
+    static float spreadPosition (int midiNoteNumber);
+
+    // Equal-power gains for a position in [-1, 1], 1 and 1 at the centre
+    static void panGains (float position, float& left, float& right);
+
+    // Allpass coefficient for the right channel; 1 (a wire) when decorrelation is 0
+    static float allpassCoefficient (int midiNoteNumber, float decorrelation);
+
+    void setParams (float pan, float spread, float decorrelation);
+    void noteOn (int midiNoteNumber);
+    void reset();
+
+    static constexpr int maxChunkSize = 64;
+
+    bool isDecorrelating() const noexcept { return allpass != 1.0f; }
+
+    // Writes the decorrelated right channel for mono into right
+    void decorrelate (const float* mono, float* right, int numSamples);
+
+    // Pans a chunk of the mono voice, up to maxChunkSize samples, into the first
+    // two channels of output, gliding to new gains across it when the pan has moved
+    void addTo (juce::AudioBuffer<float>& output, int startSample, const float* mono, int numSamples);
+
+private:
+    void updateTargets();
+
+    float pan { 0.0f };
+    float spread { 0.0f };
+    float decorrelation { 0.0f };
+    int note { 60 };
+
+    float leftGain { 1.0f }, rightGain { 1.0f };
+    float targetLeft { 1.0f }, targetRight { 1.0f };
+
+    float allpass { 1.0f };
+    float lastInput { 0.0f };
+    float lastOutput { 0.0f };
+};
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    WavetableData.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "WavetableData.h"
+
+const WavetableData& WavetableData::get (const int waveType)
+{
+    static const WavetableData sineTable { sine };
+    static const WavetableData sawTable { saw };
+    static const WavetableData squareTable { square };
+
+    switch (waveType)
+    {
+        case saw:     return sawTable;
+        case square:  return squareTable;
+        default:      return sineTable;
+    }
+}
+
+void WavetableData::buildAll()
+{
+    for (int waveType = 0; waveType < numWaveTypes; ++waveType)
+        get (waveType);
+}
+
+WavetableData::WavetableData (const int waveType)
+{
+    std::array<float, tableSize> sineCycle;
+
+    for (int i = 0; i < tableSize; ++i)
+        sineCycle[i] = (float) std::sin (juce::MathConstants<double>::twoPi * i / tableSize);
+
+    // Harmonic amplitudes of the naive shapes OscData used to generate
+    auto amplitude = [waveType] (const int harmonic) -> double
+    {
+        switch (waveType)
+        {
+            case saw:     return -2.0 / (juce::MathConstants<double>::pi * harmonic);
+            case square:  return (harmonic % 2) == 1 ? 4.0 / (juce::MathConstants<double>::pi * harmonic) : 0.0;
+            default:      return harmonic == 1 ? 1.0 : 0.0;
+        }
+    };
+
+    std::vector<double> sum ((size_t) tableSize);
+    float scale = 1.0f;
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        const auto numHarmonics = (tableSize / 2) >> level;
+        std::fill (sum.begin(), sum.end(), 0.0);
+
+        for (int h = 1; h <= numHarmonics; ++h)
+        {
+            const auto a = amplitude (h);
+
+            if (a == 0.0)
+                continue;
+
+            // h * i wraps exactly in integer arithmetic, so no sin() per harmonic
+            for (int i = 0; i < tableSize; ++i)
+                sum[(size_t) i] += a * sineCycle[(size_t) ((h * i) & (tableSize - 1))];
+        }
+
+        // Normalise every level by the widest one so octaves stay level-matched
+        if (level == 0)
+        {
+            double peak = 0.0;
+
+            for (auto v : sum)
+                peak = juce::jmax (peak, std::abs (v));
+
+            scale = peak > 0.0 ? (float) (1.0 / peak) : 1.0f;
+        }
+
+        auto& table = tables[(size_t) level];
+
+        for (int i = 0; i < tableSize; ++i)
+            table[(size_t) i] = (float) sum[(size_t) i] * scale;
+
+        table[tableSize] = table[0];
+    }
+}
+
+const float* WavetableData::getTable (const float increment) const noexcept
+{
+    // Level n holds tableSize / 2^(n + 1) harmonics, which stay below Nyquist
+    // as long as increment * tableSize < 2^n
+    auto octaves = (int) (std::abs (increment) * (float) tableSize);
+    int level = 0;
+
+    while (octaves > 0 && level < numLevels - 1)
+    {
+        octaves >>= 1;
+        ++level;
+    }
+
+    return tables[(size_t) level].data();
+}
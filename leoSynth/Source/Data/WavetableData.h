@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    WavetableData.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Band-limited single-cycle tables for the OSCWAVETYPE choices, one mip level
+// per octave. Each level only holds the harmonics that stay below Nyquist for
+// the increments routed to it, so reading the right level never aliases. The
+// tables are built once on first use, shared by every oscillator and never
+// written again.
+class WavetableData
+{
+public:
+    enum WaveType { sine, saw, square, numWaveTypes };
+
+    static constexpr int tableSize = 2048;
+    static constexpr int numLevels = 11;    // 1024 harmonics down to 1
+
+    static const WavetableData& get (const int waveType);
+
+    // get() builds a table on first use, which allocates and sums every
+    // harmonic; call this off the audio thread so no waveform switch does
+    static void buildAll();
+
+    // Increment is in cycles per sample
+    const float* getTable (const float increment) const noexcept;
+
+    // Phase is in [0, 1)
+    static float lookup (const float* table, const float phase) noexcept
+    {
+        const auto position = phase * (float) tableSize;
+        const auto index = (int) position;
+        const auto frac = position - (float) index;
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+
+    // A register of phases in [0, 1); the reads are scalar, the rest is not
+    static juce::dsp::SIMDRegister<float> lookup (const float* table, const juce::dsp::SIMDRegister<float> phase) noexcept
+    {
+        using Vec = juce::dsp::SIMDRegister<float>;
+        constexpr auto width = (int) Vec::SIMDNumElements;
+
+        const auto position = phase * (float) tableSize;
+        const auto index = Vec::truncate (position);
+        alignas (64) float indices[width], lower[width], upper[width];
+        index.copyToRawArray (indices);
+
+        for (int lane = 0; lane < width; ++lane)
+        {
+            const auto i = (int) indices[lane];
+            lower[lane] = table[i];
+            upper[lane] = table[i + 1];
+        }
+
+        const auto a = Vec::fromRawArray (lower);
+        return a + (position - index) * (Vec::fromRawArray (upper) - a);
+    }
+
+private:
+    explicit WavetableData (const int waveType);
+
+    // One guard point per level so lookup() never wraps
+    std::array<std::array<float, tableSize + 1>, numLevels> tables;
+};
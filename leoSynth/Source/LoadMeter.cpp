@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    LoadMeter.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "LoadMeter.h"
+
+template <int NumBins>
+int LoadMeter::Histogram<NumBins>::percentile (double fraction) const noexcept
+{
+    // One copy, so the scan is consistent even while the audio thread adds
+    std::array<juce::uint32, NumBins> counts;
+    juce::uint64 total = 0;
+
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        counts[i] = bins[i].load (std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    if (total == 0)
+        return 0;
+
+    const auto target = (juce::uint64) std::ceil (fraction * (double) total);
+    juce::uint64 seen = 0;
+
+    for (int i = 0; i < NumBins; ++i)
+    {
+        seen += counts[(size_t) i];
+
+        if (seen >= target)
+            return i;
+    }
+
+    return NumBins - 1;
+}
+
+//==============================================================================
+void LoadMeter::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    secondsPerTick = 1.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    clear();
+}
+
+void LoadMeter::blockFinished (juce::int64 startTicks, int numSamples, int activeVoices, int numMidiEvents) noexcept
+{
+    const auto elapsed = (double) (juce::Time::getHighResolutionTicks() - startTicks) * secondsPerTick;
+
+    if (resetRequested.exchange (false))
+        clear();
+
+    if (numSamples <= 0)
+        return;
+
+    const auto percent = (float) (100.0 * elapsed * sampleRate / numSamples);
+
+    load.add ((int) std::ceil (percent * (float) binsPerPercent));
+    voices.add (activeVoices);
+    midiEvents.add (numMidiEvents);
+
+    numBlocks.store (numBlocks.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (percent > 100.0f)
+        numOverruns.store (numOverruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (percent > loadMax.load (std::memory_order_relaxed))
+        loadMax.store (percent, std::memory_order_relaxed);
+
+    if (activeVoices > voicesMax.load (std::memory_order_relaxed))
+        voicesMax.store (activeVoices, std::memory_order_relaxed);
+
+    if (numMidiEvents > midiEventsMax.load (std::memory_order_relaxed))
+        midiEventsMax.store (numMidiEvents, std::memory_order_relaxed);
+}
+
+LoadMeter::Snapshot LoadMeter::getSnapshot() const
+{
+    Snapshot s;
+
+    s.numBlocks = numBlocks.load (std::memory_order_relaxed);
+    s.numOverruns = numOverruns.load (std::memory_order_relaxed);
+
+    s.loadP50 = (float) load.percentile (0.50) / (float) binsPerPercent;
+    s.loadP99 = (float) load.percentile (0.99) / (float) binsPerPercent;
+    s.loadMax = loadMax.load (std::memory_order_relaxed);
+
+    s.voicesP50 = voices.percentile (0.50);
+    s.voicesP99 = voices.percentile (0.99);
+    s.voicesMax = voicesMax.load (std::memory_order_relaxed);
+
+    s.midiEventsP99 = midiEvents.percentile (0.99);
+    s.midiEventsMax = midiEventsMax.load (std::memory_order_relaxed);
+
+    return s;
+}
+
+void LoadMeter::clear() noexcept
+{
+    load.clear();
+    voices.clear();
+    midiEvents.clear();
+
+    numBlocks.store (0, std::memory_order_relaxed);
+    numOverruns.store (0, std::memory_order_relaxed);
+    loadMax.store (0.0f, std::memory_order_relaxed);
+    voicesMax.store (0, std::memory_order_relaxed);
+    midiEventsMax.store (0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+juce::String LoadMeter::Snapshot::toString() const
+{
+    juce::String text;
+
+    text << "blocks " << juce::String ((juce::int64) numBlocks)
+         << ", overruns " << juce::String ((juce::int64) numOverruns)
+         << ", load p50 " << juce::String (loadP50, 1) << "% p99 " << juce::String (loadP99, 1)
+         << "% max " << juce::String (loadMax, 1) << "%"
+         << ", voices p50 " << voicesP50 << " p99 " << voicesP99 << " max " << voicesMax
+         << ", MIDI events/block p99 " << midiEventsP99 << " max " << midiEventsMax;
+
+    return text;
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Audio thread load statistics. processBlock reports each block's wall time
+// against its budget (numSamples / sampleRate), the voices left sounding and
+// the MIDI events it handled. Everything goes into fixed histograms of relaxed
+// atomics, so the audio thread never locks or allocates, and the editor or a
+// headless tool can take a Snapshot at any time from any thread.
+class LoadMeter
+{
+public:
+    static constexpr int binsPerPercent = 2;
+    static constexpr int maxLoadPercent = 400;   // anything above lands in the last bin
+    static constexpr int maxVoices = 256;
+    static constexpr int maxMidiEvents = 256;
+
+    struct Snapshot
+    {
+        juce::uint64 numBlocks { 0 };
+        juce::uint64 numOverruns { 0 };   // blocks that took longer than their budget
+
+        // Percent of the block budget; percentiles are rounded up to the bin edge
+        float loadP50 { 0.0f };
+        float loadP99 { 0.0f };
+        float loadMax { 0.0f };
+
+        int voicesP50 { 0 };
+        int voicesP99 { 0 };
+        int voicesMax { 0 };
+
+        int midiEventsP99 { 0 };
+        int midiEventsMax { 0 };
+
+        juce::String toString() const;
+    };
+
+    void prepare (double sampleRate);
+
+    // Call at the top of processBlock and pass the result to blockFinished
+    juce::int64 blockStarted() const noexcept { return juce::Time::getHighResolutionTicks(); }
+    void blockFinished (juce::int64 startTicks, int numSamples, int activeVoices, int numMidiEvents) noexcept;
+
+    Snapshot getSnapshot() const;
+
+    // Safe from any thread: the audio thread clears the counters at its next block
+    void reset() noexcept { resetRequested.store (true); }
+
+private:
+    template <int NumBins>
+    struct Histogram
+    {
+        std::array<std::atomic<juce::uint32>, NumBins> bins {};
+
+        // Only the audio thread writes, so a plain load and store is enough
+        void add (int value) noexcept
+        {
+            auto& bin = bins[(size_t) juce::jlimit (0, NumBins - 1, value)];
+            bin.store (bin.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void clear() noexcept
+        {
+            for (auto& bin : bins)
+                bin.store (0, std::memory_order_relaxed);
+        }
+
+        // Smallest bin at or below which the given fraction of the values lie
+        int percentile (double fraction) const noexcept;
+    };
+
+    void clear() noexcept;
+
+    double secondsPerTick { 0.0 };
+    double sampleRate { 44100.0 };
+
+    Histogram<maxLoadPercent * binsPerPercent + 1> load;
+    Histogram<maxVoices + 1> voices;
+    Histogram<maxMidiEvents + 1> midiEvents;
+
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> numOverruns { 0 };
+    std::atomic<float> loadMax { 0.0f };
+    std::atomic<int> voicesMax { 0 };
+    std::atomic<int> midiEventsMax { 0 };
+    std::atomic<bool> resetRequested { false };
+};
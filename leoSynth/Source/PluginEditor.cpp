@@ -13,23 +13,35 @@
 leoSynthAudioProcessorEditor::leoSynthAudioProcessorEditor (leoSynthAudioProcessor& p)
     : AudioProcessorEditor (&p),
 audioProcessor (p),
-osc (audioProcessor.apvts, "OSCWAVETYPE", "OSCFMFREQ", "OSCFMDEPTH", "OSCGAIN", "OSC1PITCH", "Oscillatore 1"),
-osc2 (audioProcessor.apvts, "OSCWAVETYPE2", "OSCFMFREQ2", "OSCFMDEPTH2", "OSCGAIN2", "OSC2PITCH", "Oscillatore 2"),
-adsr("Amp Envelope", audioProcessor.apvts, "ATTACK", "DECAY", "SUSTAIN", "RELEASE"),
+osc (audioProcessor.apvts, "OSCWAVETYPE", "OSCFMFREQ", "OSCFMDEPTH", "OSCFMMODE", "OSCFMRATIO", "OSCGAIN", "OSC1PITCH", "OSCUNISON", "OSCDETUNE", "OSCBLEND", "OSCPHASERAND", "Oscillatore 1"),
+osc2 (audioProcessor.apvts, "OSCWAVETYPE2", "OSCFMFREQ2", "OSCFMDEPTH2", "OSCFMMODE2", "OSCFMRATIO2", "OSCGAIN2", "OSC2PITCH", "OSCUNISON2", "OSCDETUNE2", "OSCBLEND2", "OSCPHASERAND2", "Oscillatore 2"),
+adsr("Amp Envelope", audioProcessor.apvts, "ATTACK", "DECAY", "SUSTAIN", "RELEASE", "ENVCURVE"),
 filter(audioProcessor.apvts, "FILTERTYPE", "FILTERFREQ", "FILTERRES"),
-modAdsr("Mod Envelope", audioProcessor.apvts, "MODATTACK", "MODDECAY", "MODSUSTAIN", "MODRELEASE"),
-delay(audioProcessor.apvts, "DELAYTIME", "DELAYFEEDBACK"),
-oscilloscope(),
+modAdsr("Mod Envelope", audioProcessor.apvts, "MODATTACK", "MODDECAY", "MODSUSTAIN", "MODRELEASE", "MODENVCURVE"),
+modMatrix(audioProcessor.apvts),
+mpe(audioProcessor.apvts, "MPE", "MPEBENDRANGE"),
+stereo(audioProcessor.apvts, "PAN", "SPREAD", "DECORRELATION"),
+engine(audioProcessor.apvts, "VOICEENGINE", "POLYPHONY", "MULTICORE", "MULTICORETHRESHOLD", "OVERSAMPLING"),
+loadMeter(audioProcessor.getLoadMeter()),
+delay(audioProcessor.apvts, "DELAYTIME", "DELAYFEEDBACK", "DELAYMIX"),
+oscilloscope(audioProcessor.getScope()),
 keyboard()
 
 {
    
-    setSize (620, 650);
+    setSize (1120, 900);
     addAndMakeVisible (osc);
     addAndMakeVisible (adsr);
     addAndMakeVisible(filter);
     addAndMakeVisible(modAdsr);
+    addAndMakeVisible(modMatrix);
+    addAndMakeVisible(mpe);
+    addAndMakeVisible(stereo);
     addAndMakeVisible(osc2);
+    addAndMakeVisible(engine);
+    addAndMakeVisible(loadMeter);
+    addAndMakeVisible(oscilloscope);
+    addAndMakeVisible(delay);
 }
 
 leoSynthAudioProcessorEditor::~leoSynthAudioProcessorEditor()
@@ -49,15 +61,25 @@ void leoSynthAudioProcessorEditor::resized()
     const auto paddingY2 = 235;
 
     const auto width = 300;
+    const auto oscWidth = 500;
     const auto height = 200;
     const auto oscHeight = 300;
+    const auto engineHeight = 100;
+    const auto scopeHeight = 150;
 
 
-    osc.setBounds (paddingX, paddingY, width, oscHeight);
-    osc2.setBounds(paddingX, osc.getBottom(), width, oscHeight);
+    osc.setBounds (paddingX, paddingY, oscWidth, oscHeight);
+    osc2.setBounds(paddingX, osc.getBottom(), oscWidth, oscHeight);
     adsr.setBounds (osc.getRight(), paddingY, width, height);
     filter.setBounds(osc.getRight(), adsr.getBottom(), width, height);
     modAdsr.setBounds(osc2.getRight(), filter.getBottom(), width, height);
+    modMatrix.setBounds(adsr.getRight(), paddingY, width, oscHeight * 2);
+    mpe.setBounds(adsr.getRight(), modMatrix.getBottom(), width, engineHeight);
+    stereo.setBounds(adsr.getRight(), mpe.getBottom(), width, scopeHeight);
+    engine.setBounds(paddingX, osc2.getBottom(), oscWidth + width, engineHeight);
+    loadMeter.setBounds(paddingX, 5, oscWidth + width, paddingY - 10);
+    oscilloscope.setBounds(paddingX, engine.getBottom(), width, scopeHeight);
+    delay.setBounds(oscilloscope.getRight(), engine.getBottom(), oscWidth, scopeHeight);
     
 }
 
@@ -14,6 +14,11 @@
 #include "UI/OscComponent.h"
 #include "UI/FilterComponent.h"
 #include "UI/DelayComponent.h"
+#include "UI/EngineComponent.h"
+#include "UI/ModMatrixComponent.h"
+#include "UI/MpeComponent.h"
+#include "UI/StereoComponent.h"
+#include "UI/LoadMeterComponent.h"
 #include "UI/Oscilloscope.h"
 #include "UI/Keyboard.h"
 
@@ -36,6 +41,11 @@ private:
     AdsrComponent adsr;
     FilterComponent filter;
     AdsrComponent modAdsr;
+    ModMatrixComponent modMatrix;
+    MpeComponent mpe;
+    StereoComponent stereo;
+    EngineComponent engine;
+    LoadMeterComponent loadMeter;
 
     
     DelayComponent delay;
@@ -24,15 +24,21 @@ leoSynthAudioProcessor::leoSynthAudioProcessor()
                        ), apvts (*this, nullptr, "Parameters", createParams())
 #endif
 {
+    WavetableData::buildAll();
     synth.addSound (new SynthSound());
-    for(int i=0; i<10; i++){
-        synth.addVoice(new SynthVoice());
-    }
+    synth.setVoiceSetup (&leoSynthAudioProcessor::setupVoice, this);
+
+    // Falls back to a single "Init" program when there is no bank
+    bank.load (PresetBank::getDefaultFile(), apvts);
+
+    // Polled rather than triggered: posting a message from the audio thread
+    // can lock and allocate inside the OS message queue
+    startTimerHz (30);
 }
 
 leoSynthAudioProcessor::~leoSynthAudioProcessor()
 {
-    
+    stopTimer();
 }
 
 //==============================================================================
@@ -75,22 +81,39 @@ double leoSynthAudioProcessor::getTailLengthSeconds() const
 
 int leoSynthAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return bank.getNumPrograms();   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                                    // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int leoSynthAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void leoSynthAudioProcessor::setCurrentProgram (int index)
 {
+    // With no blocks running there is no audio thread to hand it to
+    if (! prepared.load())
+    {
+        if (selectProgram (index))
+            syncProgram();
+
+        return;
+    }
+
+    // Applied by the audio thread at its next block
+    int start1, size1, start2, size2;
+    programFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        programQueue[(size_t) start1] = index;
+
+    programFifo.finishedWrite (size1);
 }
 
 const juce::String leoSynthAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return bank.getName (index);
 }
 
 void leoSynthAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -100,26 +123,60 @@ void leoSynthAudioProcessor::changeProgramName (int index, const juce::String& n
 //==============================================================================
 void leoSynthAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    synth.setCurrentPlaybackSampleRate (sampleRate);
-    
-    for (int i = 0; i < synth.getNumVoices(); i++)
+    const auto numChannels = getTotalNumOutputChannels();
+    applyQueuedProgram();
+
+    // Both oversamplers are built here, so switching between them at play time
+    // never allocates; the voices get room for a whole block at 4x
+    for (size_t i = 0; i < oversamplers.size(); ++i)
     {
-        if (auto voice = dynamic_cast<SynthVoice*>(synth.getVoice(i)))
-        {
-            voice->prepareToPlay (sampleRate, samplesPerBlock, getTotalNumOutputChannels());
-        }
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>> ((size_t) numChannels, i + 1,
+                                                                            juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                            true, true);
+        oversamplers[i]->initProcessing ((size_t) samplesPerBlock);
     }
+
+    oversampledMidi.ensureSize (16384);
+    maxBlockSize = samplesPerBlock;
+
+    updateMultiCore();
+    synth.prepareToPlay (sampleRate, samplesPerBlock << maxOversamplingOrder, numChannels);
+    params.markAllDirty();
+
+    // Nothing is playing, so a pending state load needs no fade
+    auto expected = (int) stateReady;
+    stateLoad.compare_exchange_strong (expected, stateIdle);
+    stateFadedOut = false;
+    loadMeter.prepare (sampleRate);
+    scope.prepare (sampleRate);
+    delay.prepareToPlay (sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+    
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    voiceBank.prepareToPlay (sampleRate, samplesPerBlock);
+   #endif
+
+    oversamplingOrder = -1;
+    setOversampling ((int) apvts.getRawParameterValue ("OVERSAMPLING")->load());
+    setLatencySamples (oversamplingLatency.load());
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
     spec.sampleRate = sampleRate;
     spec.numChannels = getTotalNumOutputChannels();
-   
+    prepared.store (true);
 }
 
 void leoSynthAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    synth.releaseResources();
+    prepared.store (false);
+    applyQueuedProgram();
+
+    const auto load = loadMeter.getSnapshot();
+
+    if (load.numBlocks > 0)
+        juce::Logger::writeToLog ("leoSynth load: " + load.toString());
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -147,6 +204,27 @@ bool leoSynthAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 #endif
 
 void leoSynthAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const AllocationTrap::ScopedRealtime realtime;
+    const auto startTicks = loadMeter.blockStarted();
+    const auto numMidiEvents = midiMessages.getNumEvents();
+
+    renderBlock (buffer, midiMessages);
+    delay.process (buffer, buffer.getNumSamples());
+
+    if (stateFade == fadeOut)
+        buffer.applyGainRamp (0, buffer.getNumSamples(), 1.0f, 0.0f);
+    else if (stateFade == fadeIn)
+        buffer.applyGainRamp (0, buffer.getNumSamples(), 0.0f, 1.0f);
+    else if (stateFade == silent)
+        buffer.clear();
+
+    scope.push (buffer, buffer.getNumSamples());
+
+    loadMeter.blockFinished (startTicks, buffer.getNumSamples(), getNumActiveVoices(), numMidiEvents);
+}
+
+void leoSynthAudioProcessor::renderBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -157,79 +235,441 @@ void leoSynthAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     
     
 
-    for (int i = 0; i < synth.getNumVoices(); ++i)
+    auto changed = updateParams() | takeProgramChange (midiMessages);
+
+    // The voices come back re-prepared for the new rate and need every setting again
+    if ((changed & ParamData::bit (ParamData::oversampling)) && setOversampling (params.getInt (ParamData::oversampling)))
+        changed = ~ParamData::Mask (0);
+
+    if (changed != 0)
+    {
+        ++paramSerial;
+
+        for (int i = 0; i < ParamData::numParams; ++i)
+            if (changed & ParamData::bit ((ParamData::Id) i))
+                paramChangedAt[(size_t) i] = paramSerial;
+
+        synth.forEachActiveVoice ([this, changed] (SynthVoice& voice, int index)
+        {
+            updateVoiceParams (voice, changed);
+            voiceUpdatedAt[(size_t) index] = paramSerial;
+        });
+    }
+
+    if (changed & ParamData::delayMask())
+        delay.setParams (params.get (ParamData::delayTime), params.get (ParamData::delayFeedback), params.get (ParamData::delayMix));
+
+    if (changed & ParamData::bit (ParamData::polyphony))
+        synth.setPolyphony (params.getInt (ParamData::polyphony));
+
+    if (changed & ParamData::mpeMask())
+        synth.setMpe (params.getInt (ParamData::mpe) != 0, params.get (ParamData::mpeBendRange));
+
+    if (changed & ParamData::modMatrixMask())
+        updateModMatrix (synth.getModMatrix());
+
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    if (changed != 0)
+        updateVoiceBankParams (changed);
+
+    // Switching engine cuts whatever the other one was playing
+    if (changed & ParamData::bit (ParamData::voiceEngine))
+    {
+        synth.allNotesOff (0, false);
+        voiceBank.allNotesOff (false);
+    }
+   #endif
+
+    if (oversampler == nullptr)
+    {
+        renderVoices (buffer, midiMessages);
+        return;
+    }
+
+    auto block = juce::dsp::AudioBlock<float> (buffer).getSubsetChannelBlock (0, (size_t) totalNumOutputChannels);
+    const auto numSamples = buffer.getNumSamples();
+
+    // The oversampler holds maxBlockSize samples; longer blocks go through in pieces
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        renderOversampled (block.getSubBlock ((size_t) start, (size_t) juce::jmin (maxBlockSize, numSamples - start)), midiMessages, start);
+}
+
+void leoSynthAudioProcessor::renderOversampled (juce::dsp::AudioBlock<float> block, const juce::MidiBuffer& midiMessages, int startSample)
+{
+    // The synth has no input, so this only runs the upsampler over silence. It
+    // is cheap, and hands us the oversampler's own buffer to render the voices into
+    auto oversampledBlock = oversampler->processSamplesUp (block);
+    oversampledBlock.clear();
+
+    jassert (oversampledBlock.getNumChannels() <= 2);
+    float* channels[2] {};
+    const auto numChannels = (int) juce::jmin ((size_t) 2, oversampledBlock.getNumChannels());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = oversampledBlock.getChannelPointer ((size_t) ch);
+
+    juce::AudioBuffer<float> oversampledBuffer (channels, numChannels, (int) oversampledBlock.getNumSamples());
+
+    const auto factor = (int) oversampler->getOversamplingFactor();
+    const auto endSample = startSample + (int) block.getNumSamples();
+    oversampledMidi.clear();
+
+    for (auto it = midiMessages.findNextSamplePosition (startSample); it != midiMessages.end(); ++it)
     {
-        if (auto voice = dynamic_cast<SynthVoice*>(synth.getVoice(i)))
+        const auto metadata = *it;
+
+        if (metadata.samplePosition >= endSample)
+            break;
+
+        oversampledMidi.addEvent (metadata.data, metadata.numBytes, (metadata.samplePosition - startSample) * factor);
+    }
+
+    renderVoices (oversampledBuffer, oversampledMidi);
+
+    // One decimation for the whole voice bus rather than one per voice
+    oversampler->processSamplesDown (block);
+}
+
+void leoSynthAudioProcessor::renderVoices (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages)
+{
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    if (params.getInt (ParamData::voiceEngine) == 1)
+    {
+        voiceBank.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+        return;
+    }
+   #endif
+
+    synth.renderBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+}
+
+bool leoSynthAudioProcessor::setOversampling (int order)
+{
+    order = juce::jlimit (0, maxOversamplingOrder, order);
+
+    if (order == oversamplingOrder)
+        return false;
+
+    oversamplingOrder = order;
+    oversampler = order > 0 ? oversamplers[(size_t) (order - 1)].get() : nullptr;
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+
+    const auto renderRate = getSampleRate() * (double) (1 << order);
+    synth.setRenderSampleRate (renderRate);
+
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    voiceBank.prepareToPlay (renderRate, getBlockSize() << order);
+   #endif
+
+    // The host hears about it from timerCallback
+    const auto latency = oversampler != nullptr ? juce::roundToInt (oversampler->getLatencyInSamples()) : 0;
+
+    oversamplingLatency.store (latency);
+
+    return true;
+}
+
+ParamData::Mask leoSynthAudioProcessor::updateParams()
+{
+    // A loaded state is taken whole at a block boundary. The parameters stay
+    // frozen while it is being written; the block before the swap fades out
+    // with the old values and the one after it fades in with the new ones.
+    const auto load = stateLoad.load (std::memory_order_acquire);
+    stateFade = noFade;
+
+    if (load == stateLoading)
+    {
+        if (stateFadedOut)
+            stateFade = silent;
+
+        return 0;
+    }
+
+    if (load == stateReady)
+    {
+        if (! stateFadedOut)
         {
-            
-            //OSC
-            auto& oscWaveChoice = *apvts.getRawParameterValue ("OSCWAVETYPE");
-            auto& fmFreq = *apvts.getRawParameterValue ("OSCFMFREQ");
-            auto& fmDepth = *apvts.getRawParameterValue ("OSCFMDEPTH");
-            auto& osc1Pitch = *apvts.getRawParameterValue("OSC1PITCH");
-            auto& osc1Gain = *apvts.getRawParameterValue ("OSCGAIN");
-
-
-            //OSC
-            auto& oscWaveChoice2 = *apvts.getRawParameterValue ("OSCWAVETYPE2");
-            auto& fmFreq2 = *apvts.getRawParameterValue ("OSCFMFREQ2");
-            auto& fmDepth2 = *apvts.getRawParameterValue ("OSCFMDEPTH2");
-            auto& osc2Pitch = *apvts.getRawParameterValue("OSC2PITCH");
-            
-            auto& osc2Gain = *apvts.getRawParameterValue ("OSCGAIN2");
-            //AMP ADSR
-            auto& attack = *apvts.getRawParameterValue ("ATTACK");
-            auto& decay = *apvts.getRawParameterValue ("DECAY");
-            auto& sustain = *apvts.getRawParameterValue ("SUSTAIN");
-            auto& release = *apvts.getRawParameterValue ("RELEASE");
-           
-            
-            // FILTER
-            auto& filterType = *apvts.getRawParameterValue("FILTERTYPE");
-            auto& cutoff = *apvts.getRawParameterValue("FILTERFREQ");
-            auto& resonance = *apvts.getRawParameterValue("FILTERRES");
-            // FILTER
-            
-            
-            // MOD ADSR
-            auto& modAttack = *apvts.getRawParameterValue ("MODATTACK");
-            auto& modDecay = *apvts.getRawParameterValue ("MODDECAY");
-            auto& modSustain = *apvts.getRawParameterValue ("MODSUSTAIN");
-            auto& modRelease = *apvts.getRawParameterValue ("MODRELEASE");
-            // MOD ADSR
-            
-          
-            auto& osc1 = voice->getOscillator1();
-            auto& osc2 = voice->getOscillator2();
-            
-            auto& adsr = voice->getAdsr();
-            auto& filterAdsr = voice->getModAdsr();
-            
-            for (int i=0; i<getTotalNumOutputChannels();i++)
-            {
-                osc1[i].setWaveType(oscWaveChoice);
-                osc1[i].setFrequency(fmFreq);
-                osc1[i].updateFm(fmFreq, fmDepth);
-                osc1[i].setGain(osc1Gain);
-                osc1[i].setPitch(osc1Pitch);
-                osc2[i].setWaveType(oscWaveChoice2);
-                osc2[i].setFrequency(fmFreq2);
-                osc2[i].updateFm(fmFreq2, fmDepth2);
-                osc2[i].setGain(osc2Gain);
-                osc2[i].setPitch(osc2Pitch);
-            }
-            adsr.updateADSR(attack.load(), decay.load(), sustain.load(), release.load());
-            filterAdsr.updateADSR(modAttack.load(), modDecay.load(), modSustain.load(), modRelease.load());
-            voice->updateFilter(filterType, cutoff, resonance);
-           
-            
+            stateFade = fadeOut;
+            stateFadedOut = true;
+            return 0;
+        }
+
+        auto expected = load;
+
+        // Another load started since the fade out: stay quiet until it is done
+        if (! stateLoad.compare_exchange_strong (expected, stateIdle))
+        {
+            stateFade = silent;
+            return 0;
         }
     }
-    
-    synth.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
 
+    if (stateFadedOut)
+    {
+        stateFade = fadeIn;
+        stateFadedOut = false;
+    }
+
+    if (programsSynced.load (std::memory_order_acquire) != programsApplied.load (std::memory_order_relaxed))
+        return 0;
+
+    return params.update();
 }
 
+int leoSynthAudioProcessor::takeQueuedProgram()
+{
+    int program = -1;
+
+    int start1, size1, start2, size2;
+    programFifo.prepareToRead (programFifo.getNumReady(), start1, size1, start2, size2);
+
+    if (size2 > 0)
+        program = programQueue[(size_t) (start2 + size2 - 1)];
+    else if (size1 > 0)
+        program = programQueue[(size_t) (start1 + size1 - 1)];
+
+    programFifo.finishedRead (size1 + size2);
+    return program;
+}
+
+bool leoSynthAudioProcessor::selectProgram (int program)
+{
+    if (program < 0 || program >= bank.getNumPrograms())
+        return false;
+
+    currentProgram.store (program);
+    programsApplied.store (programsApplied.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+}
+
+void leoSynthAudioProcessor::applyQueuedProgram()
+{
+    // A program the audio thread stopped before taking goes straight to the
+    // APVTS; prepareToPlay then picks it up with every other parameter
+    if (selectProgram (takeQueuedProgram()))
+        syncProgram();
+}
+
+ParamData::Mask leoSynthAudioProcessor::takeProgramChange (const juce::MidiBuffer& midiMessages)
+{
+    auto program = takeQueuedProgram();
+
+    // A valid MIDI program wins over the host's; bank select MSB reaches past
+    // the first 128. Like every parameter, the program takes effect at the
+    // block start rather than at its sample position
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+
+        if (message.isController() && message.getControllerNumber() == 0)
+        {
+            midiBankSelect = message.getControllerValue();
+        }
+        else if (message.isProgramChange())
+        {
+            const auto requested = midiBankSelect * 128 + message.getProgramChangeNumber();
+
+            if (requested < bank.getNumPrograms())
+                program = requested;
+        }
+    }
+
+    if (! selectProgram (program))
+        return 0;
+
+    return params.setValues (bank.getValues (program));
+}
+
+void leoSynthAudioProcessor::updateMultiCore()
+{
+    const auto enabled = apvts.getRawParameterValue (ParamData::getParamId (ParamData::multiCore))->load() > 0.5f;
+    const auto threshold = (int) apvts.getRawParameterValue (ParamData::getParamId (ParamData::multiCoreThreshold))->load();
+
+    if (enabled == multiCoreEnabled && threshold == multiCoreThreshold)
+        return;
+
+    multiCoreEnabled = enabled;
+    multiCoreThreshold = threshold;
+    synth.setMultiCore (enabled, threshold);
+}
+
+void leoSynthAudioProcessor::timerCallback()
+{
+    const auto latency = oversamplingLatency.load();
+
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
+
+    updateMultiCore();
+    syncProgram();
+}
+
+void leoSynthAudioProcessor::syncProgram()
+{
+    // Loaded before the program, so a newer program read here is synced again later
+    const auto serial = programsApplied.load (std::memory_order_acquire);
+
+    if (serial == programsSynced.load (std::memory_order_relaxed))
+        return;
+
+    const auto& values = bank.getValues (currentProgram.load());
+
+    for (int i = 0; i < ParamData::numParams; ++i)
+        if (auto* parameter = apvts.getParameter (ParamData::getParamId ((ParamData::Id) i)))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[(size_t) i]));
+
+    programsSynced.store (serial, std::memory_order_release);
+    updateHostDisplay (juce::AudioProcessor::ChangeDetails().withProgramChanged (true));
+}
+
+int leoSynthAudioProcessor::getNumActiveVoices() const
+{
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    if (params.getInt (ParamData::voiceEngine) == 1)
+        return voiceBank.getNumActiveVoices();
+   #endif
+
+    return synth.getNumActiveVoices();
+}
+
+void leoSynthAudioProcessor::setupVoice (void* context, SynthVoice& voice, int index)
+{
+    auto& processor = *static_cast<leoSynthAudioProcessor*> (context);
+    auto& updatedAt = processor.voiceUpdatedAt[(size_t) index];
+    ParamData::Mask missed = 0;
+
+    for (int i = 0; i < ParamData::numParams; ++i)
+        if (processor.paramChangedAt[(size_t) i] > updatedAt)
+            missed |= ParamData::bit ((ParamData::Id) i);
+
+    if (missed != 0)
+        processor.updateVoiceParams (voice, missed);
+
+    updatedAt = processor.paramSerial;
+}
+
+float leoSynthAudioProcessor::fmAmount (int oscIndex) const
+{
+    // Hz in fixed mode, a multiple of the carrier in ratio mode
+    using P = ParamData;
+    const auto ratioMode = params.getInt (oscIndex == 0 ? P::oscFmMode : P::oscFmMode2) == OscData::ratioFm;
+
+    if (oscIndex == 0)
+        return params.get (ratioMode ? P::oscFmRatio : P::oscFmFreq);
+
+    return params.get (ratioMode ? P::oscFmRatio2 : P::oscFmFreq2);
+}
+
+void leoSynthAudioProcessor::updateVoiceParams (SynthVoice& voice, const ParamData::Mask changed)
+{
+    using P = ParamData;
+
+    auto& osc1 = voice.getOscillator1();
+    auto& osc2 = voice.getOscillator2();
+
+    //OSC
+    if (changed & P::bit (P::oscWaveType))
+        osc1.setWaveType (params.getInt (P::oscWaveType));
+    if (changed & P::bits ({ P::oscFmMode, P::oscFmFreq, P::oscFmRatio, P::oscFmDepth }))
+        osc1.updateFm (params.getInt (P::oscFmMode), fmAmount (0), params.get (P::oscFmDepth));
+    if (changed & P::bit (P::oscGain))
+        osc1.setGain (params.get (P::oscGain));
+    if (changed & P::bit (P::osc1Pitch))
+        osc1.setPitch (params.getInt (P::osc1Pitch));
+    if (changed & P::bits ({ P::oscUnison, P::oscDetune, P::oscBlend, P::oscPhaseRandom }))
+        osc1.setUnison (params.getInt (P::oscUnison), params.get (P::oscDetune), params.get (P::oscBlend), params.get (P::oscPhaseRandom));
+
+    //OSC 2
+    if (changed & P::bit (P::oscWaveType2))
+        osc2.setWaveType (params.getInt (P::oscWaveType2));
+    if (changed & P::bits ({ P::oscFmMode2, P::oscFmFreq2, P::oscFmRatio2, P::oscFmDepth2 }))
+        osc2.updateFm (params.getInt (P::oscFmMode2), fmAmount (1), params.get (P::oscFmDepth2));
+    if (changed & P::bit (P::oscGain2))
+        osc2.setGain (params.get (P::oscGain2));
+    if (changed & P::bit (P::osc2Pitch))
+        osc2.setPitch (params.getInt (P::osc2Pitch));
+    if (changed & P::bits ({ P::oscUnison2, P::oscDetune2, P::oscBlend2, P::oscPhaseRandom2 }))
+        osc2.setUnison (params.getInt (P::oscUnison2), params.get (P::oscDetune2), params.get (P::oscBlend2), params.get (P::oscPhaseRandom2));
+
+    // AMP ADSR
+    if (changed & P::ampAdsrMask())
+    {
+        voice.getAdsr().setCurve ((AdsrData::Curve) params.getInt (P::envCurve));
+        voice.getAdsr().updateADSR (params.get (P::attack), params.get (P::decay), params.get (P::sustain), params.get (P::release));
+    }
+
+    // MOD ADSR
+    if (changed & P::modAdsrMask())
+    {
+        voice.getModAdsr().setCurve ((AdsrData::Curve) params.getInt (P::modEnvCurve));
+        voice.getModAdsr().updateADSR (params.get (P::modAttack), params.get (P::modDecay), params.get (P::modSustain), params.get (P::modRelease));
+    }
+
+    // FILTER
+    if (changed & P::filterMask())
+        voice.setFilterParams (params.getInt (P::filterType), params.get (P::filterFreq), params.get (P::filterRes));
+
+    // STEREO
+    if (changed & P::stereoMask())
+        voice.setStereoParams (params.get (P::pan), params.get (P::stereoSpread), params.get (P::decorrelation));
+}
+
+void leoSynthAudioProcessor::updateModMatrix (ModMatrixData& matrix)
+{
+    using P = ParamData;
+
+    matrix.setVoiceLfo (params.getInt (P::lfo1Shape), params.get (P::lfo1Rate));
+    matrix.setGlobalLfo (params.getInt (P::lfo2Shape), params.get (P::lfo2Rate));
+
+    for (int slot = 0; slot < ModMatrixData::numSlots; ++slot)
+    {
+        const auto first = P::mod1Source + slot * (P::mod2Source - P::mod1Source);
+        matrix.setSlot (slot, params.getInt ((P::Id) first), params.getInt ((P::Id) (first + 1)), params.get ((P::Id) (first + 2)));
+    }
+}
+
+#if LEOSYNTH_SIMD_VOICE_BANK
+void leoSynthAudioProcessor::updateVoiceBankParams (const ParamData::Mask changed)
+{
+    using P = ParamData;
+
+    if (changed & P::osc1Mask())
+        voiceBank.setOscillator (0, params.getInt (P::oscWaveType), params.getInt (P::oscFmMode), fmAmount (0), params.get (P::oscFmDepth), params.get (P::oscGain), params.getInt (P::osc1Pitch));
+
+    if (changed & P::osc2Mask())
+        voiceBank.setOscillator (1, params.getInt (P::oscWaveType2), params.getInt (P::oscFmMode2), fmAmount (1), params.get (P::oscFmDepth2), params.get (P::oscGain2), params.getInt (P::osc2Pitch));
+
+    if (changed & P::bits ({ P::oscUnison, P::oscDetune, P::oscBlend, P::oscPhaseRandom }))
+        voiceBank.setUnison (0, params.getInt (P::oscUnison), params.get (P::oscDetune), params.get (P::oscBlend), params.get (P::oscPhaseRandom));
+
+    if (changed & P::bits ({ P::oscUnison2, P::oscDetune2, P::oscBlend2, P::oscPhaseRandom2 }))
+        voiceBank.setUnison (1, params.getInt (P::oscUnison2), params.get (P::oscDetune2), params.get (P::oscBlend2), params.get (P::oscPhaseRandom2));
+
+    if (changed & P::ampAdsrMask())
+        voiceBank.setAmpAdsr (params.get (P::attack), params.get (P::decay), params.get (P::sustain), params.get (P::release), (AdsrData::Curve) params.getInt (P::envCurve));
+
+    if (changed & P::modAdsrMask())
+        voiceBank.setModAdsr (params.get (P::modAttack), params.get (P::modDecay), params.get (P::modSustain), params.get (P::modRelease), (AdsrData::Curve) params.getInt (P::modEnvCurve));
+
+    if (changed & P::bit (P::polyphony))
+        voiceBank.setPolyphony (params.getInt (P::polyphony));
+
+    if (changed & P::mpeMask())
+        voiceBank.setMpe (params.getInt (P::mpe) != 0, params.get (P::mpeBendRange));
+
+    if (changed & P::modMatrixMask())
+        updateModMatrix (voiceBank.getModMatrix());
+
+    if (changed & P::filterMask())
+        voiceBank.setFilter (params.getInt (P::filterType), params.get (P::filterFreq), params.get (P::filterRes));
+
+    if (changed & P::stereoMask())
+        voiceBank.setStereo (params.get (P::pan), params.get (P::stereoSpread), params.get (P::decorrelation));
+}
+#endif
+
 //==============================================================================
 bool leoSynthAudioProcessor::hasEditor() const
 {
@@ -247,12 +687,27 @@ void leoSynthAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
+    StateData::write (*this, destData);
 }
 
 void leoSynthAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    juce::Array<float> values;
+
+    if (! StateData::read (*this, data, sizeInBytes, values))
+        return;
+
+    auto& parameters = getParameters();
+
+    beginStateLoad();
+
+    for (int i = 0; i < parameters.size(); ++i)
+        if (auto* parameter = dynamic_cast<juce::RangedAudioParameter*> (parameters[i]))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[i]));
+
+    endStateLoad();
 }
 
 //==============================================================================
@@ -264,22 +719,46 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 
 juce::AudioProcessorValueTreeState::ParameterLayout leoSynthAudioProcessor::createParams()
 {
+    // Ratio mode's modulator frequency as a multiple of the carrier, 1:1 at the centre
+    const auto fmRatioRange = []
+    {
+        juce::NormalisableRange<float> range { 0.125f, 16.0f, 0.001f };
+        range.setSkewForCentre (1.0f);
+        return range;
+    };
+
+
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
     //OSC MAIN
     // OSC select
     params.push_back (std::make_unique<juce::AudioParameterChoice>("OSCWAVETYPE", "Osc 1 Wave Type", juce::StringArray { "Sine", "Saw", "Square" }, 0));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMFREQ", "Osc 1 FM Frequency", juce::NormalisableRange<float> { 0.0f, 1000.0f, 0.01f, 0.3f }, 0.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMDEPTH", "Osc 1 FM Depth", juce::NormalisableRange<float> { 0.0f, 1000.0f, 0.01f, 0.3f }, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("OSCFMMODE", "Osc 1 FM Mode", juce::StringArray { "Fixed", "Ratio" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMRATIO", "Osc 1 FM Ratio", fmRatioRange(), 1.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSC1PITCH", "Osc 1 Pitch", juce::NormalisableRange<float> { -64.0f, 64.0f, 1.0f}, -64.0f));
    
     params.push_back (std::make_unique<juce::AudioParameterChoice>("OSCWAVETYPE2", "Osc 2 Wave Type", juce::StringArray { "Sine", "Saw", "Square" }, 0));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMFREQ2", "Osc 2 FM Frequency", juce::NormalisableRange<float> { 0.0f, 1000.0f, 0.01f, 0.3f }, 0.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMDEPTH2", "Osc 2 FM Depth", juce::NormalisableRange<float> { 0.0f, 1000.0f, 0.01f, 0.3f }, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("OSCFMMODE2", "Osc 2 FM Mode", juce::StringArray { "Fixed", "Ratio" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCFMRATIO2", "Osc 2 FM Ratio", fmRatioRange(), 1.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("OSC2PITCH", "Osc 2 Pitch", juce::NormalisableRange<float> { -64.0f, 64.0f, 1.0f}, -64.0f));
     
     // OSC Gain
         params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCGAIN", "Oscillator 1 Gain", juce::NormalisableRange<float> { -40.0f, 0.2f, 0.1f }, 0.1f, "dB"));
         params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCGAIN2", "Oscillator 2 Gain", juce::NormalisableRange<float> { -40.0f, 0.2f, 0.1f }, 0.1f, "dB"));
+
+    // OSC Unison
+    for (int oscNumber = 1; oscNumber <= 2; ++oscNumber)
+    {
+        const auto id = oscNumber == 1 ? juce::String() : juce::String (oscNumber);
+        const auto name = "Osc " + juce::String (oscNumber);
+        params.push_back (std::make_unique<juce::AudioParameterInt>("OSCUNISON" + id, name + " Unison", 1, OscData::maxUnison, 1));
+        params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCDETUNE" + id, name + " Unison Detune", juce::NormalisableRange<float> { 0.0f, 100.0f, 0.1f }, 20.0f, "ct"));
+        params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCBLEND" + id, name + " Unison Blend", juce::NormalisableRange<float> { 0.0f, 1.0f, 0.01f }, 1.0f));
+        params.push_back (std::make_unique<juce::AudioParameterFloat>("OSCPHASERAND" + id, name + " Unison Phase", juce::NormalisableRange<float> { 0.0f, 1.0f, 0.01f }, 1.0f));
+    }
         
 
     // ADSR
@@ -287,22 +766,56 @@ juce::AudioProcessorValueTreeState::ParameterLayout leoSynthAudioProcessor::crea
     params.push_back (std::make_unique<juce::AudioParameterFloat>("DECAY", "Decay", juce::NormalisableRange<float> { 0.01f, 1.0f, 0.1f }, 0.01f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("SUSTAIN", "Sustain", juce::NormalisableRange<float> { 0.01f, 1.0f, 0.01f }, 1.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("RELEASE", "Release", juce::NormalisableRange<float> { 0.01f, 3.0f, 0.01f }, 0.4f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("ENVCURVE", "Envelope Curve", juce::StringArray { "Linear", "Exponential" }, 0));
     
     // Filter ADSR
     params.push_back (std::make_unique<juce::AudioParameterFloat>("MODATTACK", "Mod Attack", juce::NormalisableRange<float> { 0.01f, 100.0f, 0.01f }, 0.1f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("MODDECAY", "Mod Decay", juce::NormalisableRange<float> { 0.01f, 1.0f, 0.01f }, 0.1f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("MODSUSTAIN", "Mod Sustain", juce::NormalisableRange<float> { 0.01f, 1.0f, 0.01f }, 1.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("MODRELEASE", "Mod Release", juce::NormalisableRange<float> { 0.01f, 3.0f, 0.01f }, 0.4f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("MODENVCURVE", "Mod Envelope Curve", juce::StringArray { "Linear", "Exponential" }, 0));
     
     // Filter
     params.push_back (std::make_unique<juce::AudioParameterChoice>("FILTERTYPE", "Filter Type", juce::StringArray { "Low-pass", "Band-pass", "High-pass" }, 0));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("FILTERFREQ", "Filter Cutoff", juce::NormalisableRange<float> { 20.0f, 20000.0f, 0.1f, 0.6f }, 200.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat>("FILTERRES", "Filter Resonance", juce::NormalisableRange<float> { 1.0f, 10.0f, 0.1f }, 1.0f));
 
+    // Stereo
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("PAN", "Pan", juce::NormalisableRange<float> { -1.0f, 1.0f, 0.01f }, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("SPREAD", "Stereo Spread", juce::NormalisableRange<float> { 0.0f, 1.0f, 0.01f }, 0.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("DECORRELATION", "Decorrelation", juce::NormalisableRange<float> { 0.0f, 1.0f, 0.01f }, 0.0f));
+
    
     // Delay
-    params.push_back (std::make_unique<juce::AudioParameterFloat>("DELAYTIME", "Delay Time", juce::NormalisableRange<float> { 20.0f, 20000.0f, 0.1f, 0.6f }, 200.0f));
-    params.push_back (std::make_unique<juce::AudioParameterFloat>("DELAYFEEDBACK", "Feedback", juce::NormalisableRange<float> { 20.0f, 20000.0f, 0.1f, 0.6f }, 200.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("DELAYTIME", "Delay Time", juce::NormalisableRange<float> { 1.0f, DelayData::maxDelayMs, 0.1f, 0.5f }, 300.0f, "ms"));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("DELAYFEEDBACK", "Feedback", juce::NormalisableRange<float> { 0.0f, 0.95f, 0.01f }, 0.35f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("DELAYMIX", "Delay Mix", juce::NormalisableRange<float> { 0.0f, 1.0f, 0.01f }, 0.0f));
+
+    // Engine
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("VOICEENGINE", "Voice Engine", juce::StringArray { "Classic", "SIMD Bank" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterInt>("POLYPHONY", "Polyphony", 1, VoicePool::maxVoices, 10));
+    params.push_back (std::make_unique<juce::AudioParameterBool>("MULTICORE", "Multi-core Rendering", false));
+    params.push_back (std::make_unique<juce::AudioParameterInt>("MULTICORETHRESHOLD", "Multi-core Min Voices", 2, VoicePool::maxVoices, 8));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING", "Oversampling", juce::StringArray { "1x", "2x", "4x" }, 0));
+
+    // MPE
+    params.push_back (std::make_unique<juce::AudioParameterBool>("MPE", "MPE", false));
+    params.push_back (std::make_unique<juce::AudioParameterInt>("MPEBENDRANGE", "MPE Bend Range", 1, 96, 48));
+
+    // Modulation
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("LFO1SHAPE", "LFO 1 Shape", ModMatrixData::getLfoShapeNames(), 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("LFO1RATE", "LFO 1 Rate", juce::NormalisableRange<float> { 0.05f, 20.0f, 0.01f, 0.4f }, 2.0f, "Hz"));
+    params.push_back (std::make_unique<juce::AudioParameterChoice>("LFO2SHAPE", "LFO 2 Shape", ModMatrixData::getLfoShapeNames(), 0));
+    params.push_back (std::make_unique<juce::AudioParameterFloat>("LFO2RATE", "LFO 2 Rate", juce::NormalisableRange<float> { 0.05f, 20.0f, 0.01f, 0.4f }, 0.5f, "Hz"));
+
+    for (int slot = 1; slot <= ModMatrixData::numSlots; ++slot)
+    {
+        const auto id = "MOD" + juce::String (slot);
+        const auto name = "Mod " + juce::String (slot);
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(id + "SRC", name + " Source", ModMatrixData::getSourceNames(), 0));
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(id + "DST", name + " Destination", ModMatrixData::getDestinationNames(), 0));
+        params.push_back (std::make_unique<juce::AudioParameterFloat>(id + "AMT", name + " Amount", juce::NormalisableRange<float> { -1.0f, 1.0f, 0.01f }, 0.0f));
+    }
     
     return { params.begin(), params.end() };
 }
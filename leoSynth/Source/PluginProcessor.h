@@ -10,13 +10,23 @@
 
 #include <JuceHeader.h>
 #include "SynthVoice.h"
+#include "VoicePool.h"
 #include "SynthSound.h"
+#include "SimdVoiceBank.h"
+#include "AllocationTrap.h"
+#include "LoadMeter.h"
+#include "ScopeFifo.h"
+#include "PresetBank.h"
 #include "Data/FilterData.h"
+#include "Data/DelayData.h"
+#include "Data/ParamData.h"
+#include "Data/StateData.h"
 
 //==============================================================================
 /**
 */
-class leoSynthAudioProcessor  : public juce::AudioProcessor
+class leoSynthAudioProcessor  : public juce::AudioProcessor,
+                                private juce::Timer
 {
 public:
     //==============================================================================
@@ -58,10 +68,83 @@ public:
     
     juce::AudioProcessorValueTreeState apvts;
 
+    LoadMeter& getLoadMeter() noexcept { return loadMeter; }
+    ScopeFifo& getScope() noexcept { return scope; }
+
 private:
-    juce::Synthesiser synth;
+    VoicePool synth;
+    LoadMeter loadMeter;
+    ScopeFifo scope;
     juce::AudioProcessorValueTreeState::ParameterLayout createParams();
-    juce::AudioBuffer<float> mDelayBuffer;
+    void renderBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    void renderOversampled (juce::dsp::AudioBlock<float> block, const juce::MidiBuffer& midiMessages, int startSample);
+    void renderVoices (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages);
+    bool setOversampling (int order);
+    ParamData::Mask updateParams();
+    void beginStateLoad() { stateLoad.store (stateLoading); }
+    void endStateLoad() { stateLoad.store (stateReady); }
+    ParamData::Mask takeProgramChange (const juce::MidiBuffer& midiMessages);
+    int takeQueuedProgram();
+    bool selectProgram (int program);
+    void applyQueuedProgram();
+    void syncProgram();
+    void timerCallback() override;
+    int getNumActiveVoices() const;
+    void updateVoiceParams (SynthVoice& voice, const ParamData::Mask changed);
+    float fmAmount (int oscIndex) const;
+    static void setupVoice (void* context, SynthVoice& voice, int index);
+    void updateModMatrix (ModMatrixData& matrix);
+   #if LEOSYNTH_SIMD_VOICE_BANK
+    void updateVoiceBankParams (const ParamData::Mask changed);
+    SimdVoiceBank voiceBank;
+   #endif
+    ParamData params { apvts };
+    DelayData delay;
+
+    // Changes only reach the sounding voices; an idle voice catches up on the
+    // ones it missed when it starts. paramSerial counts the blocks that
+    // changed something, stamped on each parameter as it moves and on each
+    // voice as it is brought up to date
+    juce::uint64 paramSerial { 0 };
+    std::array<juce::uint64, ParamData::numParams> paramChangedAt {};
+    std::array<juce::uint64, VoicePool::maxVoices> voiceUpdatedAt {};
+
+    // setStateInformation writes the parameters between beginStateLoad and
+    // endStateLoad; the audio thread then takes them all at one block boundary
+    enum StateLoad { stateIdle, stateLoading, stateReady };
+    enum StateFade { noFade, fadeOut, silent, fadeIn };
+    std::atomic<int> stateLoad { stateIdle };
+    StateFade stateFade { noFade };
+    bool stateFadedOut { false };
+
+    // Programs requested by setCurrentProgram, for the audio thread. A program
+    // goes into ParamData first; until timerCallback has copied the latest
+    // one to the APVTS, the audio thread stops reading the APVTS. Between
+    // releaseResources and prepareToPlay it goes to the APVTS directly
+    std::atomic<bool> prepared { false };
+    PresetBank bank;
+    juce::AbstractFifo programFifo { 16 };
+    std::array<int, 16> programQueue {};
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<juce::uint32> programsApplied { 0 };
+    std::atomic<juce::uint32> programsSynced { 0 };
+    int midiBankSelect { 0 };
+
+    // Starting and stopping the render workers blocks, so this runs from
+    // prepareToPlay and timerCallback, never from the audio thread
+    void updateMultiCore();
+    bool multiCoreEnabled { false };
+    int multiCoreThreshold { -1 };
+
+    // The voices render at 2^order times the host rate straight into the
+    // oversampler's buffer, and the summed bus is decimated once per block
+    static constexpr int maxOversamplingOrder = 2;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, maxOversamplingOrder> oversamplers;
+    juce::dsp::Oversampling<float>* oversampler { nullptr };
+    int oversamplingOrder { -1 };
+    int maxBlockSize { 0 };
+    juce::MidiBuffer oversampledMidi;
+    std::atomic<int> oversamplingLatency { 0 };
    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (leoSynthAudioProcessor)
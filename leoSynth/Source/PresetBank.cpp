@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+PresetBank::PresetBank()
+{
+    // Sized once, so getValues() never sees the storage move
+    programs.resize (maxPrograms);
+}
+
+bool PresetBank::load (const juce::File& file, juce::AudioProcessorValueTreeState& apvts)
+{
+    clear (apvts);
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*> (mapped->getData());
+    const auto size = (juce::int64) mapped->getSize();
+
+    if (data == nullptr || size < headerSize
+         || juce::ByteOrder::littleEndianInt (data) != magic
+         || juce::ByteOrder::littleEndianShort (data + 4) > version)
+        return false;
+
+    const auto count = (int) juce::ByteOrder::littleEndianShort (data + 6);
+
+    if (count < 1 || count > maxPrograms || size < headerSize + (juce::int64) count * indexEntrySize)
+        return false;
+
+    // Hash of every parameter ID, in ParamData order
+    std::array<juce::uint32, ParamData::numParams> hashes;
+
+    for (int i = 0; i < ParamData::numParams; ++i)
+        hashes[(size_t) i] = StateData::hashId (ParamData::getParamId ((ParamData::Id) i));
+
+    const auto defaults = getDefaults (apvts);
+
+    for (int program = 0; program < count; ++program)
+    {
+        const auto* entry = data + headerSize + program * indexEntrySize;
+        const auto offset = (juce::int64) juce::ByteOrder::littleEndianInt (entry);
+        const auto blobSize = (juce::int64) juce::ByteOrder::littleEndianInt (entry + 4);
+        auto& values = programs[(size_t) program];
+
+        values = defaults;
+
+        if (offset + blobSize > size)
+        {
+            clear (apvts);
+            return false;
+        }
+
+        StateData::visitEntries (data + offset, (int) blobSize, [&] (juce::uint32 hash, float value)
+        {
+            for (int i = 0; i < ParamData::numParams; ++i)
+                if (hashes[(size_t) i] == hash)
+                    values[(size_t) i] = value;
+        });
+    }
+
+    mappedFile = std::move (mapped);
+    numPrograms = count;
+    return true;
+}
+
+void PresetBank::clear (juce::AudioProcessorValueTreeState& apvts)
+{
+    programs[0] = getDefaults (apvts);
+    numPrograms = 1;
+    mappedFile.reset();
+}
+
+juce::String PresetBank::getName (int index) const
+{
+    if (index < 0 || index >= numPrograms)
+        return {};
+
+    if (mappedFile == nullptr)
+        return "Init";
+
+    const auto* name = getIndexEntry (index) + 8;
+    return juce::String::fromUTF8 (name, (int) strnlen (name, nameLength));
+}
+
+const char* PresetBank::getIndexEntry (int index) const noexcept
+{
+    return static_cast<const char*> (mappedFile->getData()) + headerSize + index * indexEntrySize;
+}
+
+ParamData::Values PresetBank::getDefaults (juce::AudioProcessorValueTreeState& apvts)
+{
+    ParamData::Values values;
+
+    for (int i = 0; i < ParamData::numParams; ++i)
+    {
+        auto* parameter = apvts.getParameter (ParamData::getParamId ((ParamData::Id) i));
+        values[(size_t) i] = parameter->convertFrom0to1 (parameter->getDefaultValue());
+    }
+
+    return values;
+}
+
+//==============================================================================
+bool PresetBank::write (const juce::File& file, const juce::StringArray& names, const juce::Array<juce::MemoryBlock>& states)
+{
+    const auto count = states.size();
+
+    if (count < 1 || count > maxPrograms || names.size() != count)
+        return false;
+
+    juce::MemoryBlock bank;
+    juce::MemoryOutputStream out (bank, false);
+
+    out.writeInt ((int) magic);
+    out.writeShort ((short) version);
+    out.writeShort ((short) count);
+
+    auto offset = headerSize + count * indexEntrySize;
+
+    for (int i = 0; i < count; ++i)
+    {
+        char name[nameLength] = {};
+        names[i].copyToUTF8 (name, nameLength);   // null-padded, cut to fit
+
+        out.writeInt (offset);
+        out.writeInt ((int) states.getReference (i).getSize());
+        out.write (name, nameLength);
+
+        offset += (int) states.getReference (i).getSize();
+    }
+
+    for (auto& state : states)
+        out.write (state.getData(), state.getSize());
+
+    out.flush();
+    return file.replaceWithData (bank.getData(), bank.getSize());
+}
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+             .getChildFile ("leoSynth")
+             .getChildFile ("Programs.leobank");
+}
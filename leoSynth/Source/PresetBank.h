@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Data/ParamData.h"
+#include "Data/StateData.h"
+
+// A bank of programs in one memory-mapped file, all little-endian:
+//
+//   uint32  magic "LEOB"
+//   uint16  version
+//   uint16  number of programs
+//   then per program: uint32 offset, uint32 size, char name[nameLength]
+//   then the programs, each a StateData blob
+//
+// load() decodes every program into a ParamData::Values block up front, so a
+// program change only hands the audio thread a pointer into memory that never
+// moves: no disk access, parsing or allocation at switch time. Names are read
+// straight out of the mapping. Without a bank there is one "Init" program
+// holding the parameter defaults.
+class PresetBank
+{
+public:
+    static constexpr int maxPrograms = 1024;
+    static constexpr int nameLength = 28;
+
+    PresetBank();
+
+    // Message thread, before playback; replaces whatever was loaded
+    bool load (const juce::File& file, juce::AudioProcessorValueTreeState& apvts);
+    void clear (juce::AudioProcessorValueTreeState& apvts);
+
+    int getNumPrograms() const noexcept { return numPrograms; }
+    juce::String getName (int index) const;
+
+    // Safe on the audio thread
+    const ParamData::Values& getValues (int index) const noexcept { return programs[(size_t) index]; }
+
+    static bool write (const juce::File& file, const juce::StringArray& names, const juce::Array<juce::MemoryBlock>& states);
+    static juce::File getDefaultFile();
+
+private:
+    static constexpr juce::uint32 magic = 0x424f454c;   // "LEOB" read as little-endian
+    static constexpr int version = 1;
+    static constexpr int headerSize = 8;
+    static constexpr int indexEntrySize = 8 + nameLength;
+
+    static ParamData::Values getDefaults (juce::AudioProcessorValueTreeState& apvts);
+    const char* getIndexEntry (int index) const noexcept;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    std::vector<ParamData::Values> programs;
+    int numPrograms { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    RenderThreadPool.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "RenderThreadPool.h"
+#include "AllocationTrap.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+
+    // Queue word: batch generation in the top 32 bits, then range end, then next item
+    inline juce::uint64 pack (juce::uint32 batch, int end, int next) noexcept
+    {
+        return ((juce::uint64) batch << 32) | ((juce::uint64) end << 16) | (juce::uint64) next;
+    }
+
+    inline juce::uint32 batchOf (juce::uint64 state) noexcept { return (juce::uint32) (state >> 32); }
+    inline int endOf (juce::uint64 state) noexcept            { return (int) ((state >> 16) & 0xffff); }
+    inline int nextOf (juce::uint64 state) noexcept           { return (int) (state & 0xffff); }
+
+    constexpr int spinsBeforeSleep = 4000;
+}
+
+//==============================================================================
+class RenderThreadPool::Worker : public juce::Thread
+{
+public:
+    Worker (RenderThreadPool& p, int participantIndex)
+        : juce::Thread ("leoSynth render " + juce::String (participantIndex)),
+          pool (p),
+          participant (participantIndex)
+    {
+    }
+
+    void wake()
+    {
+        if (sleeping.load())
+            notify();
+    }
+
+    void run() override
+    {
+        // Same FP mode as the audio thread, or the voices would not render the same bits
+        juce::ScopedNoDenormals noDenormals;
+
+        auto seen = pool.generation.load (std::memory_order_acquire);
+        int idleSpins = 0;
+
+        while (! threadShouldExit())
+        {
+            const auto batch = pool.generation.load (std::memory_order_acquire);
+
+            if (batch != seen)
+            {
+                seen = batch;
+
+                const AllocationTrap::ScopedRealtime realtime;
+                pool.work (participant, batch);
+                idleSpins = 0;
+                continue;
+            }
+
+            if (++idleSpins < spinsBeforeSleep)
+            {
+                spinPause();
+                continue;
+            }
+
+            // Paired with the generation store in run(): either the audio thread
+            // sees the flag and notifies, or this load sees the new batch
+            sleeping.store (true);
+
+            if (pool.generation.load() == seen)
+                wait (100);
+
+            sleeping.store (false);
+            idleSpins = 0;
+        }
+    }
+
+private:
+    RenderThreadPool& pool;
+    const int participant;
+    std::atomic<bool> sleeping { false };
+};
+
+//==============================================================================
+RenderThreadPool::~RenderThreadPool()
+{
+    stop();
+}
+
+void RenderThreadPool::start (int numWorkers)
+{
+    stop();
+
+    // Core 0 is left to the host, so there is at most one worker per other core
+    const auto numCpus = juce::jmax (1, juce::SystemStats::getNumCpus());
+    numWorkers = juce::jlimit (0, juce::jmin (maxWorkers, numCpus - 1), numWorkers);
+    numQueues = numWorkers + 1;
+
+    for (int i = 1; i <= numWorkers; ++i)
+    {
+        auto* worker = workers.add (new Worker (*this, i));
+
+        // Worker i on core i; the mask only reaches the first 32 cores
+        if (i < 32)
+            worker->setAffinityMask (juce::uint32 (1) << i);
+
+        worker->startThread (9);
+    }
+}
+
+void RenderThreadPool::stop()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto* worker : workers)
+    {
+        worker->notify();
+        worker->stopThread (1000);
+    }
+
+    workers.clear();
+    numQueues = 1;
+}
+
+void RenderThreadPool::run (Job job, void* context, int numItems)
+{
+    jassert (numItems <= 0xffff);
+
+    if (numQueues == 1 || numItems < 2)
+    {
+        for (int i = 0; i < numItems; ++i)
+            job (context, i);
+
+        return;
+    }
+
+    const auto batch = generation.load (std::memory_order_relaxed) + 1;
+
+    currentJob.store (job, std::memory_order_relaxed);
+    currentContext.store (context, std::memory_order_relaxed);
+    remaining.store (numItems, std::memory_order_relaxed);
+
+    for (int q = 0; q < numQueues; ++q)
+    {
+        const auto begin = numItems * q / numQueues;
+        const auto end = numItems * (q + 1) / numQueues;
+        queues[(size_t) q].state.store (pack (batch, end, begin), std::memory_order_release);
+    }
+
+    generation.store (batch);
+
+    for (auto* worker : workers)
+        worker->wake();
+
+    work (0, batch);
+
+    // Only items already claimed by a worker can still be running here
+    while (remaining.load (std::memory_order_acquire) > 0)
+        spinPause();
+}
+
+void RenderThreadPool::work (int participant, juce::uint32 batch)
+{
+    for (int i = 0; i < numQueues; ++i)
+    {
+        auto& queue = queues[(size_t) ((participant + i) % numQueues)];
+        int item;
+
+        while (claim (queue, batch, item))
+        {
+            // A successful claim means this batch is still running, so these
+            // are the job and context it was started with
+            currentJob.load (std::memory_order_relaxed) (currentContext.load (std::memory_order_relaxed), item);
+            remaining.fetch_sub (1, std::memory_order_release);
+        }
+    }
+}
+
+bool RenderThreadPool::claim (Queue& queue, juce::uint32 batch, int& item)
+{
+    auto state = queue.state.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        if (batchOf (state) != batch || nextOf (state) >= endOf (state))
+            return false;
+
+        if (queue.state.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            item = nextOf (state);
+            return true;
+        }
+    }
+}
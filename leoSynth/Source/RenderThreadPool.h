@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    RenderThreadPool.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Small pool of pinned worker threads that the audio thread hands a batch of
+// independent items to, e.g. one item per sounding voice. run() splits the
+// items into one contiguous range per thread; a thread that empties its own
+// range steals from the others. Claiming an item is a single CAS on a word that
+// packs the batch generation with the range, so nothing on the audio thread
+// locks or allocates and a late worker can never pick up a stale batch.
+//
+// The calling thread works too and run() returns once every item is done.
+class RenderThreadPool
+{
+public:
+    using Job = void (*) (void* context, int item);
+
+    static constexpr int maxWorkers = 15;
+
+    RenderThreadPool() = default;
+    ~RenderThreadPool();
+
+    // Not real-time safe, call from prepareToPlay / releaseResources
+    void start (int numWorkers);
+    void stop();
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    void run (Job job, void* context, int numItems);
+
+private:
+    class Worker;
+
+    struct alignas (64) Queue
+    {
+        std::atomic<juce::uint64> state { 0 };
+    };
+
+    void work (int participant, juce::uint32 batch);
+    bool claim (Queue& queue, juce::uint32 batch, int& item);
+
+    juce::OwnedArray<Worker> workers;
+    std::array<Queue, maxWorkers + 1> queues;
+    int numQueues { 1 };
+
+    std::atomic<juce::uint32> generation { 0 };
+    std::atomic<int> remaining { 0 };
+    std::atomic<Job> currentJob { nullptr };
+    std::atomic<void*> currentContext { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderThreadPool)
+};
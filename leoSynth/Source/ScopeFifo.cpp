@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    ScopeFifo.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "ScopeFifo.h"
+
+ScopeFifo::ScopeFifo()
+{
+    samples.calloc (capacity);
+}
+
+void ScopeFifo::prepare (double newSampleRate)
+{
+    sampleRate.store (newSampleRate);
+}
+
+void ScopeFifo::push (const juce::AudioBuffer<float>& buffer, int numSamples) noexcept
+{
+    const auto numChannels = buffer.getNumChannels();
+
+    if (numChannels == 0 || fifo.getFreeSpace() == 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    const auto scale = 1.0f / (float) numChannels;
+
+    auto mixDown = [&] (int destination, int source, int n)
+    {
+        if (n <= 0)
+            return;
+
+        juce::FloatVectorOperations::copyWithMultiply (samples + destination, buffer.getReadPointer (0, source), scale, n);
+
+        for (int ch = 1; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply (samples + destination, buffer.getReadPointer (ch, source), scale, n);
+    };
+
+    mixDown (start1, 0, size1);
+    mixDown (start2, size1, size2);
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+int ScopeFifo::pull (float* destination, int maxSamples) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (maxSamples, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        juce::FloatVectorOperations::copy (destination, samples + start1, size1);
+
+    if (size2 > 0)
+        juce::FloatVectorOperations::copy (destination + size1, samples + start2, size2);
+
+    fifo.finishedRead (size1 + size2);
+    return size1 + size2;
+}
@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    ScopeFifo.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Single producer, single consumer ring of mono samples for the oscilloscope.
+// processBlock pushes the channel average of every block; the editor pulls on
+// the message thread. Both ends are wait-free and nothing is allocated after
+// construction. When no one is reading, the ring fills up and pushes are
+// dropped, which costs the audio thread one atomic load per block.
+class ScopeFifo
+{
+public:
+    static constexpr int capacity = 1 << 15;
+
+    ScopeFifo();
+
+    // Message thread, before playback starts
+    void prepare (double sampleRate);
+    double getSampleRate() const noexcept { return sampleRate.load(); }
+
+    // Audio thread
+    void push (const juce::AudioBuffer<float>& buffer, int numSamples) noexcept;
+
+    // Message thread; returns the number of samples copied, oldest first
+    int pull (float* destination, int maxSamples) noexcept;
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    juce::HeapBlock<float> samples;
+    std::atomic<double> sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ScopeFifo)
+};
@@ -0,0 +1,907 @@
+/*
+  ==============================================================================
+
+    SimdVoiceBank.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "SimdVoiceBank.h"
+#include "Data/FilterData.h"
+#include "Data/OscData.h"
+#include "Data/ExpressionData.h"
+
+#if LEOSYNTH_SIMD_VOICE_BANK
+
+SimdVoiceBank::SimdVoiceBank()
+{
+    for (int i = 0; i < 2; ++i)
+        for (int v = 0; v < maxVoices; ++v)
+            oscTable[i][v] = WavetableData::get (WavetableData::sine).getTable (0.0f);
+
+    reset();
+}
+
+void SimdVoiceBank::prepareToPlay (double newSampleRate, int samplesPerBlock)
+{
+    juce::ignoreUnused (samplesPerBlock);
+    sampleRate = newSampleRate;
+    modMatrix.setSampleRate (sampleRate);
+    expressionSmoothing = ExpressionData::smoothingCoefficient (sampleRate, controlInterval);
+    ampParams.update (sampleRate);
+    modParams.update (sampleRate);
+    reset();
+}
+
+void SimdVoiceBank::reset()
+{
+    ampStage.fill (Stage::idle);
+    modStage.fill (Stage::idle);
+    lfoPhase.fill (0.0f);
+    cutoffScale.fill (1.0f);
+    resonanceOffset.fill (0.0f);
+    snapModulation.fill (true);
+    modRelease.fill ({});
+    note.fill (-1);
+    noteChannel.fill (0);
+    keyDown.fill (false);
+    noteOnTime.fill (0);
+    groupActive.fill (false);
+
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        envLevel[v] = envAdd[v] = envLow[v] = envHigh[v] = 0.0f;
+        envMul[v] = 1.0f;
+        svfS1[v] = svfS2[v] = 0.0f;
+        svfG[v] = svfR2[v] = svfH[v] = 0.0f;
+        svfGStep[v] = svfR2Step[v] = 0.0f;
+        allpassX1[v] = allpassY1[v] = 0.0f;
+        modLevel[v] = 0.0f;
+        modGain[v] = 1.0f;
+        modGainStep[v] = 0.0f;
+
+        for (int i = 0; i < 2; ++i)
+            oscIncStep[i][v] = fmDevStep[i][v] = 0.0f;
+    }
+
+    sustainPedalDown = false;
+}
+
+//==============================================================================
+void SimdVoiceBank::noteOn (int midiChannel, int midiNoteNumber, float velocity)
+{
+    jassert (midiChannel > 0 && midiChannel <= 16);
+
+    // Retriggering a ringing note releases the old one first, like juce::Synthesiser
+    for (int v = 0; v < maxVoices; ++v)
+        if (note[v] == midiNoteNumber && noteChannel[v] == midiChannel && ampStage[v] != Stage::idle && ampStage[v] != Stage::release)
+            startRelease (v);
+
+    const auto stackSize = juce::jmin (voiceLimit, juce::jmax (osc[0].unison, osc[1].unison));
+    const auto time = ++noteOnCounter;
+
+    for (int copy = 0; copy < stackSize; ++copy)
+        startVoice (findVoiceToUse(), copy, midiChannel, midiNoteNumber, velocity, time);
+}
+
+void SimdVoiceBank::startVoice (int v, int copy, int midiChannel, int midiNoteNumber, float velocity, juce::uint32 time)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        const auto& o = osc[(size_t) i];
+        unisonDetune[i][v] = OscData::unisonRatio (copy, o.unison, o.detune);
+        unisonLevel[i][v] = copy < o.unison ? OscData::unisonLevel (copy, o.unison, o.blend) : 0.0f;
+        oscPhase[i][v] = o.unison > 1 ? o.phaseRandomness * random.nextFloat() : 0.0f;
+        fmPhase[i][v] = 0.0f;
+    }
+
+    svfS1[v] = svfS2[v] = 0.0f;
+    allpassX1[v] = allpassY1[v] = 0.0f;
+    envLevel[v] = 0.0f;
+    modLevel[v] = 0.0f;
+    ampStage[v] = Stage::attack;
+    modStage[v] = Stage::attack;
+    note[v] = midiNoteNumber;
+    noteChannel[v] = midiChannel;
+    keyDown[v] = true;
+    noteOnTime[v] = time;
+    noteVelocity[v] = velocity;
+    noteKey[v] = (float) (midiNoteNumber - 60) / 60.0f;
+    lfoPhase[v] = 0.0f;
+    cutoffScale[v] = 1.0f;
+    resonanceOffset[v] = 0.0f;
+    snapModulation[v] = true;
+
+    const auto channel = (size_t) midiChannel - 1;
+    bendTarget[v] = channelBend[channel];
+    pressureTarget[v] = channelPressure[channel];
+    timbreTarget[v] = channelTimbre[channel];
+
+    setIncrements (v);
+    updatePan (v);
+    panLeft[v] = panLeftTarget[v];
+    panRight[v] = panRightTarget[v];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        oscInc[i][v] = baseOscInc[i][v];
+        fmInc[i][v] = baseFmInc[i][v];
+        fmDev[i][v] = baseFmDev[i][v];
+    }
+
+    updateEnvelope (v);
+    updateFilterCoefficients (v, 0);
+    groupActive[v / laneWidth] = true;
+}
+
+void SimdVoiceBank::noteOff (int midiChannel, int midiNoteNumber, bool allowTailOff)
+{
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        if (note[v] != midiNoteNumber || noteChannel[v] != midiChannel || ! keyDown[v])
+            continue;
+
+        keyDown[v] = false;
+
+        if (! allowTailOff)
+        {
+            ampStage[v] = Stage::idle;
+            envLevel[v] = envAdd[v] = envLow[v] = envHigh[v] = 0.0f;
+            envMul[v] = 1.0f;
+            note[v] = -1;
+        }
+        else if (! sustainPedalDown)
+        {
+            startRelease (v);
+        }
+    }
+}
+
+void SimdVoiceBank::allNotesOff (bool allowTailOff)
+{
+    if (! allowTailOff)
+    {
+        reset();
+        return;
+    }
+
+    for (int v = 0; v < maxVoices; ++v)
+    {
+        keyDown[v] = false;
+
+        if (ampStage[v] != Stage::idle && ampStage[v] != Stage::release)
+            startRelease (v);
+    }
+}
+
+void SimdVoiceBank::handleSustainPedal (bool isDown)
+{
+    sustainPedalDown = isDown;
+
+    if (isDown)
+        return;
+
+    for (int v = 0; v < maxVoices; ++v)
+        if (! keyDown[v] && ampStage[v] != Stage::idle && ampStage[v] != Stage::release)
+            startRelease (v);
+}
+
+void SimdVoiceBank::handleMidiEvent (const juce::MidiMessage& m)
+{
+    if (m.isNoteOn())
+        noteOn (m.getChannel(), m.getNoteNumber(), m.getFloatVelocity());
+    else if (m.isNoteOff())
+        noteOff (m.getChannel(), m.getNoteNumber(), true);
+    else if (m.isAllNotesOff() || m.isAllSoundOff())
+        allNotesOff (true);
+    else if (m.isSustainPedalOn())
+        handleSustainPedal (true);
+    else if (m.isSustainPedalOff())
+        handleSustainPedal (false);
+    else if (m.isController() && m.getControllerNumber() == 1)
+        modMatrix.setModWheel ((float) m.getControllerValue() / 127.0f);
+    else if (m.isController() && m.getControllerNumber() == 74)
+        setTimbre (m.getChannel(), ExpressionData::timbreFromMidi (m.getControllerValue()));
+    else if (m.isPitchWheel())
+        setPitchBend (m.getChannel(), m.getPitchWheelValue());
+    else if (m.isChannelPressure())
+        setPressure (m.getChannel(), ExpressionData::pressureFromMidi (m.getChannelPressureValue()));
+    else if (m.isAftertouch())
+    {
+        for (int v = 0; v < maxVoices; ++v)
+            if (note[v] == m.getNoteNumber() && noteChannel[v] == m.getChannel())
+                pressureTarget[v] = ExpressionData::pressureFromMidi (m.getAfterTouchValue());
+    }
+}
+
+void SimdVoiceBank::setPitchBend (int midiChannel, int wheelValue)
+{
+    if (mpe && midiChannel == masterChannel)
+    {
+        modMatrix.setMasterPitchBend (ExpressionData::bendToSemitones (wheelValue, masterBendRange));
+        return;
+    }
+
+    const auto semitones = ExpressionData::bendToSemitones (wheelValue, mpe ? mpeBendRange : masterBendRange);
+    channelBend[(size_t) midiChannel - 1] = semitones;
+
+    for (int v = 0; v < maxVoices; ++v)
+        if (noteChannel[v] == midiChannel)
+            bendTarget[v] = semitones;
+}
+
+void SimdVoiceBank::setPressure (int midiChannel, float pressure)
+{
+    channelPressure[(size_t) midiChannel - 1] = pressure;
+
+    for (int v = 0; v < maxVoices; ++v)
+        if (noteChannel[v] == midiChannel)
+            pressureTarget[v] = pressure;
+}
+
+void SimdVoiceBank::setTimbre (int midiChannel, float timbre)
+{
+    channelTimbre[(size_t) midiChannel - 1] = timbre;
+
+    for (int v = 0; v < maxVoices; ++v)
+        if (noteChannel[v] == midiChannel)
+            timbreTarget[v] = timbre;
+}
+
+void SimdVoiceBank::setMpe (bool shouldUseMpe, float bendRange)
+{
+    if (mpe && ! shouldUseMpe)
+        modMatrix.setMasterPitchBend (0.0f);
+
+    // Like the voice pool, a new range applies from the next bend message
+    mpe = shouldUseMpe;
+    mpeBendRange = bendRange;
+}
+
+int SimdVoiceBank::findVoiceToUse() const
+{
+    int oldest = 0, oldestReleased = -1;
+
+    for (int v = 0; v < voiceLimit; ++v)
+    {
+        if (ampStage[v] == Stage::idle)
+            return v;
+
+        if (noteOnTime[v] < noteOnTime[oldest])
+            oldest = v;
+
+        if (ampStage[v] == Stage::release && (oldestReleased < 0 || noteOnTime[v] < noteOnTime[oldestReleased]))
+            oldestReleased = v;
+    }
+
+    return oldestReleased >= 0 ? oldestReleased : oldest;
+}
+
+//==============================================================================
+void SimdVoiceBank::setOscillator (int index, int waveType, int fmMode, float fmAmount, float fmDepth, float gainInDecibels, int pitch)
+{
+    jassert (index == 0 || index == 1);
+    auto& o = osc[(size_t) index];
+    o.waveType = waveType;
+    o.fmMode = fmMode;
+    o.fmAmount = fmAmount;
+    o.fmDepth = fmDepth;
+    o.gain = juce::Decibels::decibelsToGain (gainInDecibels);
+    o.pitchOffset = (float) juce::MidiMessage::getMidiNoteInHertz (pitch);
+
+    for (int v = 0; v < maxVoices; ++v)
+        if (ampStage[v] != Stage::idle)
+            setIncrements (v);
+}
+
+void SimdVoiceBank::EnvParams::update (double sampleRate)
+{
+    attackSegment = AdsrData::makeSegment (curve, 1.0f, 1.0f, attack, sampleRate);
+    decaySegment = AdsrData::makeSegment (curve, sustain, sustain - 1.0f, decay, sampleRate);
+}
+
+void SimdVoiceBank::setAmpAdsr (float attack, float decay, float sustain, float release, AdsrData::Curve curve)
+{
+    ampParams.attack = attack;
+    ampParams.decay = decay;
+    ampParams.sustain = sustain;
+    ampParams.release = release;
+    ampParams.curve = curve;
+    ampParams.update (sampleRate);
+}
+
+void SimdVoiceBank::setModAdsr (float attack, float decay, float sustain, float release, AdsrData::Curve curve)
+{
+    modParams.attack = attack;
+    modParams.decay = decay;
+    modParams.sustain = sustain;
+    modParams.release = release;
+    modParams.curve = curve;
+    modParams.update (sampleRate);
+}
+
+void SimdVoiceBank::setFilter (int newFilterType, float cutoff, float resonance)
+{
+    filterType = newFilterType;
+    filterCutoff = cutoff;
+    filterResonance = resonance;
+}
+
+void SimdVoiceBank::setStereo (float pan, float spread, float decorrelation)
+{
+    // The allpass state is stale if it has been switched out
+    if (stereoDecorrelation == 0.0f && decorrelation > 0.0f)
+    {
+        std::fill (std::begin (allpassX1), std::end (allpassX1), 0.0f);
+        std::fill (std::begin (allpassY1), std::end (allpassY1), 0.0f);
+    }
+
+    stereoPan = pan;
+    stereoSpread = spread;
+    stereoDecorrelation = decorrelation;
+
+    // Sounding voices glide to their new place over the next tick
+    for (int v = 0; v < maxVoices; ++v)
+        if (ampStage[v] != Stage::idle)
+            updatePan (v);
+}
+
+void SimdVoiceBank::setUnison (int index, int numVoices, float detuneCents, float blend, float phaseRandomness)
+{
+    jassert (index == 0 || index == 1);
+    auto& o = osc[(size_t) index];
+    o.unison = juce::jlimit (1, OscData::maxUnison, numVoices);
+    o.detune = detuneCents;
+    o.blend = blend;
+    o.phaseRandomness = phaseRandomness;
+}
+
+void SimdVoiceBank::setPolyphony (int numVoices)
+{
+    // Voices above a lowered limit keep sounding, they are just not reused
+    voiceLimit = juce::jlimit (1, maxVoices, numVoices);
+}
+
+int SimdVoiceBank::getNumActiveVoices() const
+{
+    return (int) std::count_if (ampStage.begin(), ampStage.end(), [] (Stage s) { return s != Stage::idle; });
+}
+
+void SimdVoiceBank::setIncrements (int v)
+{
+    const auto noteHz = (float) juce::MidiMessage::getMidiNoteInHertz (note[v]);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        // Same fixed/ratio FM mapping as OscData::updateIncrements
+        const auto& o = osc[(size_t) i];
+        const auto carrierHz = std::abs (noteHz + o.pitchOffset);
+        const auto ratio = o.fmMode == OscData::ratioFm;
+
+        // A unison copy scales the carrier, FM swing included, like OscData's stack
+        baseOscInc[i][v] = carrierHz * unisonDetune[i][v] / (float) sampleRate;
+        baseFmInc[i][v] = (ratio ? carrierHz * o.fmAmount : o.fmAmount) / (float) sampleRate;
+        baseFmDev[i][v] = (ratio ? carrierHz * o.fmDepth * 0.01f : o.fmDepth) * unisonDetune[i][v] / (float) sampleRate;
+        oscTable[i][v] = WavetableData::get (o.waveType).getTable (baseOscInc[i][v] + baseFmDev[i][v]);
+    }
+}
+
+void SimdVoiceBank::updatePan (int v)
+{
+    StereoData::panGains (stereoPan + stereoSpread * StereoData::spreadPosition (note[v]), panLeftTarget[v], panRightTarget[v]);
+    allpassCoef[v] = StereoData::allpassCoefficient (note[v], stereoDecorrelation);
+}
+
+//==============================================================================
+void SimdVoiceBank::startRelease (int v)
+{
+    ampStage[v] = Stage::release;
+    setEnvelopeSegment (v, AdsrData::makeSegment (ampParams.curve, 0.0f, -envLevel[v], ampParams.release, sampleRate), envLevel[v]);
+
+    modStage[v] = Stage::release;
+    modRelease[v] = AdsrData::makeSegment (modParams.curve, 0.0f, -modLevel[v], modParams.release, sampleRate);
+}
+
+// The render loop runs level * mul + add and clamps it between the segment's
+// start and end, so a stage can never overshoot whatever its curve
+void SimdVoiceBank::setEnvelopeSegment (int v, const AdsrData::Segment& segment, float from)
+{
+    envMul[v] = segment.mul;
+    envAdd[v] = segment.add;
+    envLow[v] = juce::jmin (from, segment.end);
+    envHigh[v] = juce::jmax (from, segment.end);
+}
+
+void SimdVoiceBank::updateEnvelope (int v)
+{
+    switch (ampStage[v])
+    {
+        case Stage::attack:
+            if (envLevel[v] < 1.0f)
+            {
+                setEnvelopeSegment (v, ampParams.attackSegment, 0.0f);
+                break;
+            }
+
+            ampStage[v] = Stage::decay;
+            [[fallthrough]];
+
+        case Stage::decay:
+            if (envLevel[v] > ampParams.sustain)
+            {
+                setEnvelopeSegment (v, ampParams.decaySegment, 1.0f);
+                break;
+            }
+
+            ampStage[v] = Stage::sustain;
+            [[fallthrough]];
+
+        case Stage::sustain:
+            setEnvelopeSegment (v, { 1.0f, 0.0f, ampParams.sustain, ampParams.sustain }, ampParams.sustain);
+            break;
+
+        case Stage::release:
+            if (envLevel[v] <= 0.0f)
+            {
+                ampStage[v] = Stage::idle;
+                envLevel[v] = envAdd[v] = envLow[v] = envHigh[v] = 0.0f;
+                envMul[v] = 1.0f;
+                note[v] = -1;
+            }
+            break;
+
+        case Stage::idle:
+            break;
+    }
+}
+
+void SimdVoiceBank::updateModEnvelope (int v, int numSamples)
+{
+    auto& level = modLevel[v];
+
+    switch (modStage[v])
+    {
+        case Stage::attack:
+            level = AdsrData::advance (modParams.attackSegment, level, numSamples);
+
+            if (level >= 1.0f)
+            {
+                level = 1.0f;
+                modStage[v] = Stage::decay;
+            }
+            break;
+
+        case Stage::decay:
+            level = AdsrData::advance (modParams.decaySegment, level, numSamples);
+
+            if (level <= modParams.sustain)
+            {
+                level = modParams.sustain;
+                modStage[v] = Stage::sustain;
+            }
+            break;
+
+        case Stage::sustain:
+            level = modParams.sustain;
+            break;
+
+        case Stage::release:
+            level = juce::jmax (0.0f, AdsrData::advance (modRelease[v], level, numSamples));
+            break;
+
+        case Stage::idle:
+            break;
+    }
+}
+
+void SimdVoiceBank::updateFilterCoefficients (int v, int rampSamples)
+{
+    const auto nyquistLimit = juce::jmin (20000.0f, (float) sampleRate * 0.49f);
+    const auto cutoff = juce::jlimit (20.0f, nyquistLimit, filterCutoff * modLevel[v] * cutoffScale[v]);
+    const auto g = FilterData::prewarp (cutoff / (float) sampleRate);
+    const auto r2 = 1.0f / juce::jlimit (1.0f, 10.0f, filterResonance + resonanceOffset[v]);
+
+    // Like FilterData::setModulation: glide there over the tick, or jump
+    if (rampSamples > 0)
+    {
+        svfGStep[v] = (g - svfG[v]) / (float) rampSamples;
+        svfR2Step[v] = (r2 - svfR2[v]) / (float) rampSamples;
+        return;
+    }
+
+    svfG[v] = g;
+    svfR2[v] = r2;
+    svfGStep[v] = svfR2Step[v] = 0.0f;
+    svfH[v] = 1.0f / (1.0f + r2 * g + g * g);
+}
+
+void SimdVoiceBank::updateModulation (int group, int numSamples)
+{
+    using M = ModMatrixData;
+
+    updateExpression (group);
+
+    const auto offset = group * laneWidth;
+    const auto lfoAdvance = modMatrix.getVoiceLfoRate() * (float) numSamples / (float) sampleRate;
+    alignas (64) float lfo[laneWidth] {};
+    alignas (64) float modulation[M::numDestinations][laneWidth] {};
+
+    for (int lane = 0; lane < laneWidth; ++lane)
+    {
+        auto& phase = lfoPhase[(size_t) (offset + lane)];
+        phase += lfoAdvance;
+        phase -= std::floor (phase);
+        lfo[lane] = M::lfo (modMatrix.getVoiceLfoShape(), phase);
+    }
+
+    // Every route is one multiply-add for the whole register of voices
+    if (! modMatrix.isEmpty())
+    {
+        Vec sources[M::numSources];
+        sources[M::noSource] = Vec::expand (0.0f);
+        sources[M::ampEnvelope] = Vec::fromRawArray (envLevel + offset);
+        sources[M::modEnvelope] = Vec::fromRawArray (modLevel + offset);
+        sources[M::voiceLfo] = Vec::fromRawArray (lfo);
+        sources[M::globalLfo] = Vec::expand (modMatrix.getGlobalLfo (tickEnd));
+        sources[M::velocity] = Vec::fromRawArray (noteVelocity + offset);
+        sources[M::key] = Vec::fromRawArray (noteKey + offset);
+        sources[M::modWheel] = Vec::expand (modMatrix.getModWheel());
+        sources[M::pressure] = Vec::fromRawArray (notePressure + offset);
+        sources[M::timbre] = Vec::fromRawArray (noteTimbre + offset);
+
+        Vec destinations[M::numDestinations];
+
+        for (auto& destination : destinations)
+            destination = Vec::expand (0.0f);
+
+        modMatrix.process (sources, destinations);
+
+        for (int d = 0; d < M::numDestinations; ++d)
+            destinations[d].copyToRawArray (modulation[d]);
+    }
+
+    const auto retable = modMatrix.targets (M::pitch) || modMatrix.targets (M::fmDepth);
+
+    for (int lane = 0; lane < laneWidth; ++lane)
+    {
+        const auto v = offset + lane;
+
+        if (ampStage[v] == Stage::idle)
+        {
+            svfGStep[v] = svfR2Step[v] = 0.0f;
+            continue;
+        }
+
+        // Targets for the tick's end; the render loop ramps there per sample
+        const auto ratio = M::pitchRatio (modulation[M::pitch][lane]) * std::exp2 (noteBend[v] / 12.0f);
+        const auto depth = M::fmDepthScale (modulation[M::fmDepth][lane]);
+        const auto gain = M::gainScale (modulation[M::gain][lane]);
+        const auto snap = snapModulation[v];
+
+        cutoffScale[v] = M::cutoffScale (modulation[M::cutoff][lane]);
+        resonanceOffset[v] = M::resonanceOffset (modulation[M::resonance][lane]);
+        updateFilterCoefficients (v, snap ? 0 : numSamples);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            const auto inc = juce::jmin (baseOscInc[i][v] * ratio, 0.5f);
+            const auto dev = baseFmDev[i][v] * depth;
+
+            if (snap)
+            {
+                oscInc[i][v] = inc;
+                fmDev[i][v] = dev;
+            }
+
+            oscIncStep[i][v] = (inc - oscInc[i][v]) / (float) numSamples;
+            fmDevStep[i][v] = (dev - fmDev[i][v]) / (float) numSamples;
+            fmInc[i][v] = osc[(size_t) i].fmMode == OscData::ratioFm ? baseFmInc[i][v] * ratio : baseFmInc[i][v];
+
+            if (retable)
+                oscTable[i][v] = WavetableData::get (osc[(size_t) i].waveType).getTable (inc + dev);
+        }
+
+        if (snap)
+            modGain[v] = gain;
+
+        modGainStep[v] = (gain - modGain[v]) / (float) numSamples;
+        snapModulation[v] = false;
+    }
+}
+
+void SimdVoiceBank::updateExpression (int group)
+{
+    // One register of voices glides towards its targets; a voice's first tick
+    // jumps there, as ExpressionData::snap does
+    const auto offset = group * laneWidth;
+    const auto masterBend = Vec::expand (modMatrix.getMasterPitchBend());
+    const auto coefficient = Vec::expand (expressionSmoothing);
+
+    auto glide = [&] (float* current, const float* target, Vec offsetToAdd)
+    {
+        const auto from = Vec::fromRawArray (current + offset);
+        const auto to = Vec::fromRawArray (target + offset) + offsetToAdd;
+        (from + (to - from) * coefficient).copyToRawArray (current + offset);
+    };
+
+    const auto zero = Vec::expand (0.0f);
+    glide (noteBend, bendTarget, masterBend);
+    glide (notePressure, pressureTarget, zero);
+    glide (noteTimbre, timbreTarget, zero);
+
+    for (int v = offset; v < offset + laneWidth; ++v)
+    {
+        if (snapModulation[v])
+        {
+            noteBend[v] = bendTarget[v] + modMatrix.getMasterPitchBend();
+            notePressure[v] = pressureTarget[v];
+            noteTimbre[v] = timbreTarget[v];
+        }
+    }
+}
+
+void SimdVoiceBank::updateControl (int numSamples)
+{
+    for (int group = 0; group < numGroups; ++group)
+    {
+        if (! groupActive[group])
+            continue;
+
+        bool anyActive = false;
+
+        for (int v = group * laneWidth; v < (group + 1) * laneWidth; ++v)
+        {
+            if (ampStage[v] == Stage::idle)
+                continue;
+
+            updateEnvelope (v);
+            updateModEnvelope (v, numSamples);
+            anyActive = anyActive || ampStage[v] != Stage::idle;
+        }
+
+        groupActive[group] = anyActive;
+
+        if (anyActive)
+            updateModulation (group, numSamples);
+    }
+}
+
+//==============================================================================
+void SimdVoiceBank::renderNextBlock (juce::AudioBuffer<float>& outputBuffer, const juce::MidiBuffer& midiMessages, int startSample, int numSamples)
+{
+    const auto endSample = startSample + numSamples;
+    const auto numChannels = outputBuffer.getNumChannels();
+    auto position = startSample;
+
+    const auto output = numChannels < 2 ? monoOutput
+                      : stereoDecorrelation > 0.0f ? decorrelatedOutput : stereoOutput;
+
+    auto renderUpTo = [&] (int end)
+    {
+        while (position < end)
+        {
+            const auto num = juce::jmin (controlInterval, end - position);
+            float mixLeft[controlInterval] = {};
+            float mixRight[controlInterval] = {};
+
+            tickEnd = modMatrix.getClock() + (position - startSample) + num;
+            render (mixLeft, mixRight, num, output);
+
+            if (numChannels > 0)
+                juce::FloatVectorOperations::add (outputBuffer.getWritePointer (0, position), mixLeft, num);
+
+            if (numChannels > 1)
+                juce::FloatVectorOperations::add (outputBuffer.getWritePointer (1, position), mixRight, num);
+
+            position += num;
+        }
+    };
+
+    for (const auto metadata : midiMessages)
+    {
+        if (metadata.samplePosition >= endSample)
+            break;
+
+        const auto message = metadata.getMessage();
+
+        const auto time = juce::jmax (position, metadata.samplePosition);
+
+        // Expression and other controllers only set targets, which the voices
+        // pick up at their next tick. They are taken at the start of the tick
+        // they fall in, so a dense stream leaves the ticks whole
+        if (message.isPitchWheel() || message.isChannelPressure() || message.isAftertouch()
+            || (message.isController() && (message.getControllerNumber() == 1 || message.getControllerNumber() == 74)))
+            renderUpTo (position + (time - position) / controlInterval * controlInterval);
+        else
+            renderUpTo (time);
+
+        handleMidiEvent (message);
+    }
+
+    renderUpTo (endSample);
+    modMatrix.advanceClock (numSamples);
+}
+
+void SimdVoiceBank::render (float* mixLeft, float* mixRight, int numSamples, Output output)
+{
+    updateControl (numSamples);
+
+    // One instantiation per filter type and output, so the sample loop has no branches
+    using Render = void (SimdVoiceBank::*) (int, float*, float*, int);
+    static constexpr Render renderers[3][3] =
+    {
+        { &SimdVoiceBank::renderGroup<0, monoOutput>, &SimdVoiceBank::renderGroup<0, stereoOutput>, &SimdVoiceBank::renderGroup<0, decorrelatedOutput> },
+        { &SimdVoiceBank::renderGroup<1, monoOutput>, &SimdVoiceBank::renderGroup<1, stereoOutput>, &SimdVoiceBank::renderGroup<1, decorrelatedOutput> },
+        { &SimdVoiceBank::renderGroup<2, monoOutput>, &SimdVoiceBank::renderGroup<2, stereoOutput>, &SimdVoiceBank::renderGroup<2, decorrelatedOutput> }
+    };
+
+    const auto renderer = renderers[juce::jlimit (0, 2, filterType)][output];
+
+    for (int group = 0; group < numGroups; ++group)
+        if (groupActive[group])
+            (this->*renderer) (group, mixLeft, mixRight, numSamples);
+}
+
+// Sine is computed in-register; saw and square read each lane's band-limited
+// mip level from WavetableData
+SimdVoiceBank::Vec SimdVoiceBank::oscillator (int index, int offset, Vec phase) const
+{
+    if (osc[(size_t) index].waveType == WavetableData::sine)
+        return OscData::fastSine (phase);
+
+    alignas (64) float phases[laneWidth];
+    alignas (64) float out[laneWidth];
+    phase.copyToRawArray (phases);
+
+    for (int lane = 0; lane < laneWidth; ++lane)
+        out[lane] = WavetableData::lookup (oscTable[index][offset + lane], phases[lane]);
+
+    return Vec::fromRawArray (out);
+}
+
+template <int FilterType, SimdVoiceBank::Output OutputMode>
+void SimdVoiceBank::renderGroup (int group, float* mixLeft, float* mixRight, int numSamples)
+{
+    const auto offset = group * laneWidth;
+
+    auto p1 = Vec::fromRawArray (oscPhase[0] + offset);
+    auto p2 = Vec::fromRawArray (oscPhase[1] + offset);
+    auto f1 = Vec::fromRawArray (fmPhase[0] + offset);
+    auto f2 = Vec::fromRawArray (fmPhase[1] + offset);
+    auto i1 = Vec::fromRawArray (oscInc[0] + offset);
+    auto i2 = Vec::fromRawArray (oscInc[1] + offset);
+    const auto fi1 = Vec::fromRawArray (fmInc[0] + offset);
+    const auto fi2 = Vec::fromRawArray (fmInc[1] + offset);
+    auto fd1 = Vec::fromRawArray (fmDev[0] + offset);
+    auto fd2 = Vec::fromRawArray (fmDev[1] + offset);
+    auto gain = Vec::fromRawArray (modGain + offset);
+    const auto i1Step = Vec::fromRawArray (oscIncStep[0] + offset);
+    const auto i2Step = Vec::fromRawArray (oscIncStep[1] + offset);
+    const auto fd1Step = Vec::fromRawArray (fmDevStep[0] + offset);
+    const auto fd2Step = Vec::fromRawArray (fmDevStep[1] + offset);
+    const auto gainStep = Vec::fromRawArray (modGainStep + offset);
+
+    auto level = Vec::fromRawArray (envLevel + offset);
+    const auto mul = Vec::fromRawArray (envMul + offset);
+    const auto add = Vec::fromRawArray (envAdd + offset);
+    const auto low = Vec::fromRawArray (envLow + offset);
+    const auto high = Vec::fromRawArray (envHigh + offset);
+
+    auto s1 = Vec::fromRawArray (svfS1 + offset);
+    auto s2 = Vec::fromRawArray (svfS2 + offset);
+    auto g = Vec::fromRawArray (svfG + offset);
+    auto r2 = Vec::fromRawArray (svfR2 + offset);
+    auto h = Vec::fromRawArray (svfH + offset);
+    const auto gStep = Vec::fromRawArray (svfGStep + offset);
+    const auto r2Step = Vec::fromRawArray (svfR2Step + offset);
+    const auto one = Vec::expand (1.0f);
+    const auto two = Vec::expand (2.0f);
+
+    // The pan glides to its target across the tick
+    auto gainLeft = Vec::fromRawArray (panLeft + offset);
+    auto gainRight = Vec::fromRawArray (panRight + offset);
+    const auto leftTarget = Vec::fromRawArray (panLeftTarget + offset);
+    const auto rightTarget = Vec::fromRawArray (panRightTarget + offset);
+    const auto leftStep = (leftTarget - gainLeft) * (1.0f / (float) numSamples);
+    const auto rightStep = (rightTarget - gainRight) * (1.0f / (float) numSamples);
+
+    const auto a = Vec::fromRawArray (allpassCoef + offset);
+    auto x1 = Vec::fromRawArray (allpassX1 + offset);
+    auto y1 = Vec::fromRawArray (allpassY1 + offset);
+
+    // Each copy's level in its unison stack, at the oscillator's gain
+    const auto level1 = Vec::fromRawArray (unisonLevel[0] + offset) * osc[0].gain;
+    const auto level2 = Vec::fromRawArray (unisonLevel[1] + offset) * osc[1].gain;
+
+    for (int s = 0; s < numSamples; ++s)
+    {
+        // Audio-rate FM: the modulator offsets the carrier increment every sample
+        const auto mod1 = OscData::fastSine (f1) * fd1;
+        const auto mod2 = OscData::fastSine (f2) * fd2;
+        f1 = OscData::wrapPhase (f1 + fi1);
+        f2 = OscData::wrapPhase (f2 + fi2);
+
+        auto x = oscillator (0, offset, p1) * level1 + oscillator (1, offset, p2) * level2;
+        p1 = OscData::wrapPhase (p1 + i1 + mod1);
+        p2 = OscData::wrapPhase (p2 + i2 + mod2);
+
+        // Modulation ramps, reaching the tick's targets on its last sample
+        i1 += i1Step;
+        i2 += i2Step;
+        fd1 += fd1Step;
+        fd2 += fd2Step;
+        gain += gainStep;
+        g += gStep;
+        r2 += r2Step;
+
+        // h = 1 / (1 + r2 g + g^2) follows the coefficients with two Newton
+        // steps from the last sample's value, which is already close
+        const auto d = one + r2 * g + g * g;
+        h = h * (two - d * h);
+        h = h * (two - d * h);
+
+        level = Vec::max (Vec::min (level * mul + add, high), low);
+        x = x * level * gain * outputGain;
+
+        const auto yHP = h * (x - s1 * (g + r2) - s2);
+        const auto yBP = yHP * g + s1;
+        s1 = yHP * g + yBP;
+        const auto yLP = yBP * g + s2;
+        s2 = yBP * g + yLP;
+
+        const auto y = FilterType == 0 ? yLP : (FilterType == 1 ? yBP : yHP);
+
+        if (OutputMode == monoOutput)
+        {
+            mixLeft[s] += y.sum();
+            continue;
+        }
+
+        gainLeft += leftStep;
+        gainRight += rightStep;
+        mixLeft[s] += (y * gainLeft).sum();
+
+        if (OutputMode == stereoOutput)
+        {
+            mixRight[s] += (y * gainRight).sum();
+        }
+        else
+        {
+            // First-order allpass, y[n] = a * (x[n] - y[n - 1]) + x[n - 1]
+            y1 = a * (y - y1) + x1;
+            x1 = y;
+            mixRight[s] += (y1 * gainRight).sum();
+        }
+    }
+
+    if (OutputMode != monoOutput)
+    {
+        leftTarget.copyToRawArray (panLeft + offset);
+        rightTarget.copyToRawArray (panRight + offset);
+    }
+
+    if (OutputMode == decorrelatedOutput)
+    {
+        x1.copyToRawArray (allpassX1 + offset);
+        y1.copyToRawArray (allpassY1 + offset);
+    }
+
+    p1.copyToRawArray (oscPhase[0] + offset);
+    p2.copyToRawArray (oscPhase[1] + offset);
+    i1.copyToRawArray (oscInc[0] + offset);
+    i2.copyToRawArray (oscInc[1] + offset);
+    fd1.copyToRawArray (fmDev[0] + offset);
+    fd2.copyToRawArray (fmDev[1] + offset);
+    gain.copyToRawArray (modGain + offset);
+    f1.copyToRawArray (fmPhase[0] + offset);
+    f2.copyToRawArray (fmPhase[1] + offset);
+    level.copyToRawArray (envLevel + offset);
+    s1.copyToRawArray (svfS1 + offset);
+    s2.copyToRawArray (svfS2 + offset);
+    g.copyToRawArray (svfG + offset);
+    r2.copyToRawArray (svfR2 + offset);
+    h.copyToRawArray (svfH + offset);
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    SimdVoiceBank.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Data/WavetableData.h"
+#include "Data/AdsrData.h"
+#include "Data/ModMatrixData.h"
+#include "Data/StereoData.h"
+
+// Build with LEOSYNTH_SIMD_VOICE_BANK=0 to leave only the VoicePool path
+#ifndef LEOSYNTH_SIMD_VOICE_BANK
+ #define LEOSYNTH_SIMD_VOICE_BANK 1
+#endif
+
+#if LEOSYNTH_SIMD_VOICE_BANK
+
+// Alternative voice engine: the state of every voice (oscillator and FM phases,
+// envelopes, SVF integrators) lives in structure-of-arrays form and is rendered
+// one SIMD register at a time, i.e. 4 voices per instruction with SSE/NEON and
+// 8 with AVX. The sound matches SynthVoice: two oscillators with FM, an amp
+// ADSR, and a TPT state variable filter whose cutoff follows the mod ADSR.
+// The mod matrix is evaluated once per control tick for a whole register of
+// voices; pitch, FM depth, gain and the filter coefficients then ramp per
+// sample across the tick.
+// Voices are mono up to the filter, then panned (and decorrelated) per lane
+// into the left and right mixes, with StereoData's per-note placement.
+//
+// Per-note expression follows SynthVoice: bend, pressure and CC74 on a note's
+// channel set per-voice targets, which glide a register at a time once per
+// tick into pitch and the matrix's pressure and timbre sources. Controls only
+// set targets, so unlike notes they never split the block.
+//
+// A unison stack takes one voice per detuned copy, so the copies of a note
+// share registers and cost what as many notes would; each voice carries its
+// copy of both oscillators, silent where that oscillator's stack is smaller.
+// Voice counts and polyphony here count the copies. Unison settings apply
+// from the next note.
+class SimdVoiceBank
+{
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int laneWidth = (int) Vec::SIMDNumElements;
+    static constexpr int maxVoices = 64;
+    static constexpr int numGroups = maxVoices / laneWidth;
+    static constexpr int controlInterval = 16;
+
+    SimdVoiceBank();
+
+    void prepareToPlay (double sampleRate, int samplesPerBlock);
+    void reset();
+
+    void noteOn (int midiChannel, int midiNoteNumber, float velocity);
+    void noteOff (int midiChannel, int midiNoteNumber, bool allowTailOff);
+    void allNotesOff (bool allowTailOff);
+    void handleSustainPedal (bool isDown);
+    void handleMidiEvent (const juce::MidiMessage& m);
+
+    void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, const juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+
+    // fmAmount is in Hz in fixed mode and a multiple of the carrier in ratio mode
+    void setOscillator (int index, int waveType, int fmMode, float fmAmount, float fmDepth, float gainInDecibels, int pitch);
+    void setAmpAdsr (float attack, float decay, float sustain, float release, AdsrData::Curve curve);
+    void setModAdsr (float attack, float decay, float sustain, float release, AdsrData::Curve curve);
+    void setFilter (int filterType, float cutoff, float resonance);
+    void setStereo (float pan, float spread, float decorrelation);
+    void setUnison (int index, int numVoices, float detuneCents, float blend, float phaseRandomness);
+    void setPolyphony (int numVoices);
+    void setMpe (bool shouldUseMpe, float bendRange);
+
+    int getNumActiveVoices() const;
+    ModMatrixData& getModMatrix() noexcept { return modMatrix; }
+
+private:
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    struct OscParams
+    {
+        int waveType { 0 };
+        int fmMode { 0 };
+        float fmAmount { 0.0f };
+        float fmDepth { 0.0f };
+        float gain { 1.0f };
+        float pitchOffset { 0.0f };
+        int unison { 1 };
+        float detune { 0.0f };
+        float blend { 1.0f };
+        float phaseRandomness { 0.0f };
+    };
+
+    struct EnvParams
+    {
+        float attack { 0.1f }, decay { 0.1f }, sustain { 1.0f }, release { 0.1f };
+        AdsrData::Curve curve { AdsrData::linear };
+
+        // Attack and decay do not depend on the level they start from
+        AdsrData::Segment attackSegment, decaySegment;
+
+        void update (double sampleRate);
+    };
+
+    // How the voices reach the output: summed mono, panned, or panned with the
+    // right channel decorrelated
+    enum Output { monoOutput, stereoOutput, decorrelatedOutput };
+
+    void render (float* mixLeft, float* mixRight, int numSamples, Output output);
+    void updateControl (int numSamples);
+    void updateEnvelope (int voice);
+    void updateModEnvelope (int voice, int numSamples);
+    void setEnvelopeSegment (int voice, const AdsrData::Segment& segment, float from);
+    void updateModulation (int group, int numSamples);
+    void updateFilterCoefficients (int voice, int rampSamples);
+    void startRelease (int voice);
+    void setIncrements (int voice);
+    void updatePan (int voice);
+    void startVoice (int voice, int copy, int midiChannel, int midiNoteNumber, float velocity, juce::uint32 time);
+    void setPitchBend (int midiChannel, int wheelValue);
+    void setPressure (int midiChannel, float pressure);
+    void setTimbre (int midiChannel, float timbre);
+    void updateExpression (int group);
+    int findVoiceToUse() const;
+
+    template <int FilterType, Output OutputMode>
+    void renderGroup (int group, float* mixLeft, float* mixRight, int numSamples);
+    Vec oscillator (int index, int offset, Vec phase) const;
+
+    // Per-voice state, one float per voice
+    alignas (64) float oscPhase[2][maxVoices] {};
+    alignas (64) float oscInc[2][maxVoices] {};
+    alignas (64) float oscIncStep[2][maxVoices] {};
+    alignas (64) float fmPhase[2][maxVoices] {};
+    alignas (64) float fmInc[2][maxVoices] {};
+    alignas (64) float fmDev[2][maxVoices] {};
+    alignas (64) float fmDevStep[2][maxVoices] {};
+    alignas (64) float modGain[maxVoices] {};
+    alignas (64) float modGainStep[maxVoices] {};
+    alignas (64) float envLevel[maxVoices] {};
+    alignas (64) float envMul[maxVoices] {};
+    alignas (64) float envAdd[maxVoices] {};
+    alignas (64) float envLow[maxVoices] {};
+    alignas (64) float envHigh[maxVoices] {};
+    alignas (64) float svfG[maxVoices] {};
+    alignas (64) float svfR2[maxVoices] {};
+    alignas (64) float svfGStep[maxVoices] {};
+    alignas (64) float svfR2Step[maxVoices] {};
+    alignas (64) float svfH[maxVoices] {};
+    alignas (64) float svfS1[maxVoices] {};
+    alignas (64) float svfS2[maxVoices] {};
+    alignas (64) float panLeft[maxVoices] {};
+    alignas (64) float panRight[maxVoices] {};
+    alignas (64) float panLeftTarget[maxVoices] {};
+    alignas (64) float panRightTarget[maxVoices] {};
+    alignas (64) float allpassCoef[maxVoices] {};
+    alignas (64) float allpassX1[maxVoices] {};
+    alignas (64) float allpassY1[maxVoices] {};
+
+    // Each voice's place in its note's unison stack, per oscillator
+    alignas (64) float unisonLevel[2][maxVoices] {};
+    float unisonDetune[2][maxVoices] {};
+
+    // Modulation sources the matrix reads a register at a time
+    alignas (64) float modLevel[maxVoices] {};
+    alignas (64) float noteVelocity[maxVoices] {};
+    alignas (64) float noteKey[maxVoices] {};
+    alignas (64) float notePressure[maxVoices] {};
+    alignas (64) float noteTimbre[maxVoices] {};
+
+    // Expression the note has been sent; the smoothed bend is in semitones
+    alignas (64) float noteBend[maxVoices] {};
+    alignas (64) float bendTarget[maxVoices] {};
+    alignas (64) float pressureTarget[maxVoices] {};
+    alignas (64) float timbreTarget[maxVoices] {};
+
+    // Band-limited mip level per voice, picked from its increment
+    const float* oscTable[2][maxVoices];
+
+    // Scalar bookkeeping, only touched at control rate
+    std::array<Stage, maxVoices> ampStage;
+    std::array<Stage, maxVoices> modStage;
+    std::array<float, maxVoices> lfoPhase;
+    std::array<float, maxVoices> cutoffScale;
+    std::array<float, maxVoices> resonanceOffset;
+    std::array<bool, maxVoices> snapModulation;
+
+    // Unmodulated increments, which the matrix scales every tick
+    float baseOscInc[2][maxVoices] {};
+    float baseFmInc[2][maxVoices] {};
+    float baseFmDev[2][maxVoices] {};
+    std::array<AdsrData::Segment, maxVoices> modRelease;
+    std::array<int, maxVoices> note;
+    std::array<int, maxVoices> noteChannel;
+    std::array<bool, maxVoices> keyDown;
+    std::array<juce::uint32, maxVoices> noteOnTime;
+    juce::uint32 noteOnCounter { 0 };
+    std::array<bool, numGroups> groupActive;
+
+    std::array<OscParams, 2> osc;
+    EnvParams ampParams, modParams;
+    ModMatrixData modMatrix;
+    juce::int64 tickEnd { 0 };
+    int voiceLimit { maxVoices };
+    int filterType { 0 };
+    float filterCutoff { 200.0f };
+    float filterResonance { 1.0f };
+    float stereoPan { 0.0f };
+    float stereoSpread { 0.0f };
+    float stereoDecorrelation { 0.0f };
+    bool mpe { false };
+    float mpeBendRange { 48.0f };
+    float expressionSmoothing { 1.0f };
+    std::array<float, 16> channelBend {};
+    std::array<float, 16> channelPressure {};
+    std::array<float, 16> channelTimbre {};
+    bool sustainPedalDown { false };
+    double sampleRate { 44100.0 };
+    juce::Random random { 0x5eed };
+
+    static constexpr float outputGain { 0.07f };
+    static constexpr int masterChannel = 1;
+    static constexpr float masterBendRange = 2.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimdVoiceBank)
+};
+
+#endif
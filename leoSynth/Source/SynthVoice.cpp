@@ -18,13 +18,26 @@ bool SynthVoice::canPlaySound (juce::SynthesiserSound* sound)
 
 void SynthVoice::startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound *sound, int currentPitchWheelPosition)
 {
-    for (int i=0; i<2; i++){
-        osc[i].setWaveFrequency (midiNoteNumber);
-        osc2[i].setWaveFrequency (midiNoteNumber);
-
-    }
+    osc.setWaveFrequency (midiNoteNumber);
+    osc2.setWaveFrequency (midiNoteNumber);
+    osc.resetModulation();
+    osc2.resetModulation();
+    osc.retriggerUnison();
+    osc2.retriggerUnison();
     adsr.noteOn();
     modAdsr.noteOn();
+
+    filter.resetAll();
+    stereo.noteOn (midiNoteNumber);
+    samplesUntilTick = 0;
+
+    noteVelocity = velocity;
+    noteKey = (float) (midiNoteNumber - 60) / 60.0f;
+    lfoPhase = 0.0f;
+    firstTick = true;
+
+    expression.reset();
+    expression.setPitchBend (ExpressionData::bendToSemitones (currentPitchWheelPosition, pitchBendRange));
 }
 
 void SynthVoice::stopNote (float velocity, bool allowTailOff)
@@ -38,30 +51,48 @@ void SynthVoice::stopNote (float velocity, bool allowTailOff)
 
 void SynthVoice::controllerMoved (int controllerNumber, int newControllerValue)
 {
-    
+    if (controllerNumber == 74)
+        expression.setTimbre (ExpressionData::timbreFromMidi (newControllerValue));
 }
 
 void SynthVoice::pitchWheelMoved (int newPitchWheelValue)
 {
-    
+    expression.setPitchBend (ExpressionData::bendToSemitones (newPitchWheelValue, pitchBendRange));
+}
+
+void SynthVoice::aftertouchChanged (int newAftertouchValue)
+{
+    expression.setPressure (ExpressionData::pressureFromMidi (newAftertouchValue));
+}
+
+void SynthVoice::channelPressureChanged (int newChannelPressureValue)
+{
+    expression.setPressure (ExpressionData::pressureFromMidi (newChannelPressureValue));
+}
+
+void SynthVoice::setInitialExpression (float pressure, float timbre) noexcept
+{
+    expression.setPressure (pressure);
+    expression.setTimbre (timbre);
 }
 
 void SynthVoice::prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels)
 {
     reset();
+    voiceSampleRate = sampleRate;
+    expressionSmoothing = ExpressionData::smoothingCoefficient (sampleRate, FilterData::controlInterval);
     adsr.setSampleRate (sampleRate);
     modAdsr.setSampleRate(sampleRate);
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
     spec.sampleRate = sampleRate;
-    spec.numChannels = outputChannels;
-    for( int ch=0; ch< numChannelsToProcess; ch++){
-        osc[ch].prepareToPlay (sampleRate, samplesPerBlock, outputChannels);
-        osc2[ch].prepareToPlay (sampleRate, samplesPerBlock, outputChannels);
-        filter[ch].prepareToPlay(sampleRate, samplesPerBlock, outputChannels);
-    }
+    spec.numChannels = 1;
+    osc.prepareToPlay (sampleRate, samplesPerBlock, 1);
+    osc2.prepareToPlay (sampleRate, samplesPerBlock, 1);
+    filter.prepareToPlay (sampleRate, samplesPerBlock, 1);
     gain.prepare (spec);
     gain.setGainLinear (0.07f);
+
     isPrepared = true;
 }
 
@@ -71,56 +102,157 @@ void SynthVoice::renderNextBlock (juce::AudioBuffer< float > &outputBuffer, int
     
     if (! isVoiceActive())
         return;
-    
-    synthBuffer.setSize (outputBuffer.getNumChannels(), numSamples, false, false, true);
-    modAdsr.applyEnvelopeToBuffer(synthBuffer, 0, numSamples);
-    filterAdsrOutput = modAdsr.getNextSample();
-    synthBuffer.clear();
-    
-    for (int ch= 0; ch < synthBuffer.getNumChannels(); ch++){
-        auto* buffer = synthBuffer.getWritePointer(ch, 0);
-        for (int s=0; s<synthBuffer.getNumSamples(); ++s)
+
+    static_assert (FilterData::controlInterval <= StereoData::maxChunkSize, "A tick must fit the stereo stage's chunk");
+    alignas (64) float chunk[FilterData::controlInterval];
+
+    // The whole chain runs tick by tick: modulation is evaluated once per
+    // control tick and the oscillators, gain and filter glide across it.
+    // Each tick is rendered into a chunk on the stack and added straight into
+    // the output, so the voice keeps no buffer of its own. Ticks carry over
+    // from block to block
+    for (int start = 0; start < numSamples;)
+    {
+        if (samplesUntilTick == 0)
         {
-            buffer[s] =
-            osc[ch].processNextSample(buffer[s])+osc2[ch].processNextSample(buffer[s]);
+            updateModulation();
+            samplesUntilTick = FilterData::controlInterval;
         }
+
+        const auto n = juce::jmin (samplesUntilTick, numSamples - start);
+
+        if (useReferenceKernel)
+            renderTickReference (chunk, n);
+        else
+            renderTickFused (chunk, n);
+
+        if (outputBuffer.getNumChannels() == 1)
+            outputBuffer.addFrom (0, startSample + start, chunk, n);
+        else
+            stereo.addTo (outputBuffer, startSample + start, chunk, n);
+
+        start += n;
+        samplesUntilTick -= n;
+        sampleTime += n;
     }
-    
-    juce::dsp::AudioBlock<float> audioBlock { synthBuffer };
-    gain.process(juce::dsp::ProcessContextReplacing<float> (audioBlock));
-    adsr.applyEnvelopeToBuffer(synthBuffer, 0, synthBuffer.getNumSamples());
 
-    for (int ch = 0; ch< synthBuffer.getNumChannels(); ++ch)
+    if (! adsr.isActive())
+        clearCurrentNote();
+}
+
+void SynthVoice::renderTickFused (float* output, int numSamples)
+{
+    jassert (numSamples <= FilterData::controlInterval);
+
+    alignas (64) float mix[FilterData::controlInterval];
+    alignas (64) float envelope[FilterData::controlInterval];
+
+    juce::FloatVectorOperations::clear (mix, numSamples);
+    osc.renderNextBlock (mix, numSamples);
+    osc2.renderNextBlock (mix, numSamples);
+    adsr.render (envelope, numSamples);
+
+    // Output level and modulation gain ramp as one; sample i gets what
+    // applyGainRamp would give it
+    const auto level = gain.getGainLinear();
+    const auto amplitude = level * modGain;
+    const auto amplitudeStep = level * modGainStep;
+
+    filter.processMono ([&] (int i) { return mix[i] * envelope[i] * (amplitude + amplitudeStep * (float) i); },
+                        output, numSamples);
+
+    modGain += modGainStep * (float) numSamples;
+}
+
+void SynthVoice::renderTickReference (float* output, int numSamples)
+{
+    // Wraps the chunk without copying or allocating
+    juce::AudioBuffer<float> buffer (&output, 1, numSamples);
+    juce::FloatVectorOperations::clear (output, numSamples);
+    osc.renderNextBlock (output, numSamples);
+    osc2.renderNextBlock (output, numSamples);
+
+    juce::dsp::AudioBlock<float> audioBlock { buffer };
+    gain.process (juce::dsp::ProcessContextReplacing<float> (audioBlock));
+    adsr.applyEnvelopeToBuffer (buffer, 0, numSamples);
+
+    if (modGainStep != 0.0f || modGain != 1.0f)
+    {
+        const auto endGain = modGain + modGainStep * (float) numSamples;
+        buffer.applyGainRamp (0, numSamples, modGain, endGain);
+        modGain = endGain;
+    }
+
+    filter.process (buffer, 0, numSamples);
+}
+
+void SynthVoice::updateModulation()
+{
+    // Sources are taken at the tick's end, and everything glides there
+    const auto modulator = modAdsr.skip (FilterData::controlInterval);
+    const auto masterBend = modMatrix != nullptr ? modMatrix->getMasterPitchBend() : 0.0f;
+    float destinations[ModMatrixData::numDestinations] {};
+
+    if (firstTick)
+        expression.snap (masterBend);
+    else
+        expression.tick (expressionSmoothing, masterBend);
+
+    if (modMatrix != nullptr)
     {
-        auto* buffer = synthBuffer.getWritePointer(ch, 0);
-        for (int s = 0; s< synthBuffer.getNumSamples();  ++s)
+        lfoPhase += modMatrix->getVoiceLfoRate() * (float) (FilterData::controlInterval / voiceSampleRate);
+        lfoPhase -= std::floor (lfoPhase);
+
+        if (! modMatrix->isEmpty())
         {
-            buffer[s] = filter[ch].processNextSample(ch, synthBuffer.getSample(ch,s));
+            float sources[ModMatrixData::numSources] {};
+            sources[ModMatrixData::ampEnvelope] = adsr.getLevel();
+            sources[ModMatrixData::modEnvelope] = modulator;
+            sources[ModMatrixData::voiceLfo] = ModMatrixData::lfo (modMatrix->getVoiceLfoShape(), lfoPhase);
+            sources[ModMatrixData::globalLfo] = modMatrix->getGlobalLfo (sampleTime + FilterData::controlInterval);
+            sources[ModMatrixData::velocity] = noteVelocity;
+            sources[ModMatrixData::key] = noteKey;
+            sources[ModMatrixData::modWheel] = modMatrix->getModWheel();
+            sources[ModMatrixData::pressure] = expression.getPressure();
+            sources[ModMatrixData::timbre] = expression.getTimbre();
+
+            modMatrix->process (sources, destinations);
         }
     }
-    for (int channel = 0; channel < outputBuffer.getNumChannels(); ++channel)
+
+    filter.setModulation (modulator * ModMatrixData::cutoffScale (destinations[ModMatrixData::cutoff]),
+                          FilterData::controlInterval,
+                          ModMatrixData::resonanceOffset (destinations[ModMatrixData::resonance]));
+
+    const auto pitchRatio = ModMatrixData::pitchRatio (destinations[ModMatrixData::pitch])
+                          * std::exp2 (expression.getPitchBend() / 12.0f);
+    const auto fmDepthScale = ModMatrixData::fmDepthScale (destinations[ModMatrixData::fmDepth]);
+
+    osc.setModulation (pitchRatio, fmDepthScale, FilterData::controlInterval);
+    osc2.setModulation (pitchRatio, fmDepthScale, FilterData::controlInterval);
+
+    const auto targetGain = ModMatrixData::gainScale (destinations[ModMatrixData::gain]);
+
+    if (firstTick)
     {
-        outputBuffer.addFrom (channel, startSample, synthBuffer, channel, 0, numSamples);
-        
-        if (! adsr.isActive())
-            clearCurrentNote();
+        modGain = targetGain;
+        modGainStep = 0.0f;
+        firstTick = false;
+    }
+    else
+    {
+        modGainStep = (targetGain - modGain) / (float) FilterData::controlInterval;
     }
-    
-    
-    
 }
-void SynthVoice::updateFilter (const int filterType, const float frequency, const float resonance)
+
+void SynthVoice::setFilterParams (const int filterType, const float frequency, const float resonance)
 {
-    float modulator = modAdsr.getNextSample();
-    updateModParams(filterType, frequency, resonance, modulator);
+    filter.setParams (filterType, frequency, resonance);
 }
-void SynthVoice::updateModParams (const int filterType, const float frequency, const float resonance, const float modulator)
+
+void SynthVoice::setStereoParams (const float pan, const float spread, const float decorrelation)
 {
-    auto cutoff = filterAdsrOutput + frequency;
-    for (int ch=0; ch<numChannelsToProcess; ++ch)
-    {
-        filter[ch].setParams(filterType, cutoff, resonance, modulator);
-    }
+    stereo.setParams (pan, spread, decorrelation);
 }
 
 void SynthVoice::reset()
@@ -128,4 +260,6 @@ void SynthVoice::reset()
     gain.reset();
     adsr.reset();
     modAdsr.reset();
+    stereo.reset();
+    expression.reset();
 }
@@ -14,6 +14,15 @@
 #include "Data/OscData.h"
 #include "Data/AdsrData.h"
 #include "Data/FilterData.h"
+#include "Data/ModMatrixData.h"
+#include "Data/StereoData.h"
+#include "Data/ExpressionData.h"
+
+// Build with LEOSYNTH_FUSED_VOICE_KERNEL=0 to render voices with the
+// multi-pass reference kernel only
+#ifndef LEOSYNTH_FUSED_VOICE_KERNEL
+ #define LEOSYNTH_FUSED_VOICE_KERNEL 1
+#endif
 
 class SynthVoice : public juce::SynthesiserVoice
 {
@@ -23,31 +32,70 @@ public:
     void stopNote (float velocity, bool allowTailOff) override;
     void controllerMoved (int controllerNumber, int newControllerValue) override;
     void pitchWheelMoved (int newPitchWheelValue) override;
+    void aftertouchChanged (int newAftertouchValue) override;
+    void channelPressureChanged (int newChannelPressureValue) override;
     void prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels);
+
+    // Adds the voice into outputBuffer. The voice is mono up to the pan and
+    // decorrelation stage, which is the only part that sees the output's channels
     void renderNextBlock (juce::AudioBuffer< float > &outputBuffer, int startSample, int numSamples) override;
     
     void reset();
     
-    std::array<OscData, 2>& getOscillator1() { return osc; }
-    std::array<OscData, 2>& getOscillator2() { return osc2; }
+    OscData& getOscillator1() { return osc; }
+    OscData& getOscillator2() { return osc2; }
     
     AdsrData& getAdsr() {return adsr;}
     AdsrData& getModAdsr() {return modAdsr;}
-    float getFilterAdsrOutput() {return filterAdsrOutput;}
-    void updateFilter (const int filterType, const float frequency, const float resonance);
-    void updateModParams (const int filterType, const float frequency, const float resonance, const float modulator);
+    void setFilterParams (const int filterType, const float frequency, const float resonance);
+    void setStereoParams (const float pan, const float spread, const float decorrelation);
+
+    // The fused kernel computes each sample in one pass: oscillators mixed in
+    // a stack chunk, then level, envelope and modulation gain as one amplitude
+    // and the filter in the same loop, with a single write to the tick's chunk.
+    // The reference kernel runs the same stages as separate passes over the
+    // chunk; it stays for checking and benchmarking the fused one
+    void setReferenceKernel (bool shouldUseReference) noexcept { useReferenceKernel = shouldUseReference; }
+
+    // The routing and shared sources, owned by the pool; without one the voice
+    // plays unmodulated. The sample time is the pool's clock at the note start
+    void setModMatrix (const ModMatrixData* matrix) noexcept { modMatrix = matrix; }
+    void setSampleTime (juce::int64 time) noexcept { sampleTime = time; }
+
+    // Per-note expression. Bend, pressure and timbre (CC74) arrive on the
+    // note's channel and only set targets; they reach pitch and the matrix's
+    // pressure and timbre sources smoothed, once per control tick
+    void setPitchBendRange (float semitones) noexcept { pitchBendRange = semitones; }
+    void setInitialExpression (float pressure, float timbre) noexcept;
 
    
     
 private:
-    juce::AudioBuffer<float> synthBuffer;
-    static constexpr int numChannelsToProcess { 2 };
-    std::array<OscData, numChannelsToProcess> osc;
-    std::array<OscData, numChannelsToProcess> osc2;
-    std::array<FilterData, numChannelsToProcess> filter;
+    void updateModulation();
+    void renderTickFused (float* output, int numSamples);
+    void renderTickReference (float* output, int numSamples);
+
+    OscData osc;
+    OscData osc2;
+    FilterData filter;
+    StereoData stereo;
     AdsrData adsr;
     AdsrData modAdsr;
-    float filterAdsrOutput {0.0f};
+    int samplesUntilTick { 0 };
+
+    const ModMatrixData* modMatrix { nullptr };
+    ExpressionData expression;
+    float expressionSmoothing { 1.0f };
+    float pitchBendRange { 2.0f };
+    double voiceSampleRate { 44100.0 };
+    juce::int64 sampleTime { 0 };
+    float noteVelocity { 0.0f };
+    float noteKey { 0.0f };
+    float lfoPhase { 0.0f };
+    float modGain { 1.0f };
+    float modGainStep { 0.0f };
+    bool firstTick { true };
+    bool useReferenceKernel { LEOSYNTH_FUSED_VOICE_KERNEL == 0 };
     juce::dsp::Gain<float> gain;
     bool isPrepared { false };
 };
@@ -11,13 +11,17 @@
 #include "AdsrComponent.h"
 
 //==============================================================================
-AdsrComponent::AdsrComponent (juce::String name, juce::AudioProcessorValueTreeState& apvts, juce::String attackId, juce::String decayId, juce::String sustainId, juce::String releaseId)
+AdsrComponent::AdsrComponent (juce::String name, juce::AudioProcessorValueTreeState& apvts, juce::String attackId, juce::String decayId, juce::String sustainId, juce::String releaseId, juce::String curveId)
 {
     componentName = name;
     setSliderWithLabel (attackSlider, attackLabel, apvts, attackId, attackAttachment);
     setSliderWithLabel (decaySlider, decayLabel, apvts, decayId, decayAttachment);
     setSliderWithLabel (sustainSlider, sustainLabel, apvts, sustainId, sustainAttachment);
     setSliderWithLabel (releaseSlider, releaseLabel, apvts, releaseId, releaseAttachment);
+
+    curveSelector.addItemList ({ "Linear", "Exponential" }, 1);
+    addAndMakeVisible (curveSelector);
+    curveSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(apvts, curveId, curveSelector);
 }
 
 AdsrComponent::~AdsrComponent()
@@ -59,6 +63,9 @@ void AdsrComponent::resized()
     
     releaseSlider.setBounds (sustainSlider.getRight() + padding, sliderStartY, sliderWidth, sliderHeight);
     releaseLabel.setBounds (releaseSlider.getX(), labelStart, sliderWidth, labelHeight);
+
+    // In the title row, right-aligned
+    curveSelector.setBounds (getWidth() - 125, 7, 110, 20);
 }
 
 using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
@@ -17,7 +17,7 @@
 class AdsrComponent  : public juce::Component
 {
 public:
-    AdsrComponent (juce::String name, juce::AudioProcessorValueTreeState& apvts, juce::String attackId, juce::String decayId, juce::String sustainId, juce::String releaseId);
+    AdsrComponent (juce::String name, juce::AudioProcessorValueTreeState& apvts, juce::String attackId, juce::String decayId, juce::String sustainId, juce::String releaseId, juce::String curveId);
     ~AdsrComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -36,6 +36,9 @@ private:
     juce::Slider decaySlider;
     juce::Slider sustainSlider;
     juce::Slider releaseSlider;
+
+    juce::ComboBox curveSelector { "Envelope Curve" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> curveSelectorAttachment;
     
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     
@@ -12,10 +12,11 @@
 #include "DelayComponent.h"
 
 //==============================================================================
-DelayComponent::DelayComponent(juce::AudioProcessorValueTreeState& apvts, juce::String delayTimeId, juce::String delayFeedbackId)
+DelayComponent::DelayComponent(juce::AudioProcessorValueTreeState& apvts, juce::String delayTimeId, juce::String delayFeedbackId, juce::String delayMixId)
 {
     setSliderWithLabel(delayTimeSlider, delayTimeLabel, apvts, delayTimeId, delayTimeAttachment);
     setSliderWithLabel(delayFeedbackSlider, delayFeedbackLabel, apvts, delayFeedbackId, delayFeedbackAttachment);
+    setSliderWithLabel(delayMixSlider, delayMixLabel, apvts, delayMixId, delayMixAttachment);
 
 }
 
@@ -51,6 +52,10 @@ void DelayComponent::resized()
     delayFeedbackSlider.setBounds(delayTimeSlider.getRight(), startY, sliderWidth, sliderHeight);
     delayFeedbackLabel.setBounds(delayFeedbackSlider.getX(), delayFeedbackSlider.getY()-labelYOffset, delayFeedbackSlider.getWidth(), labelHeight);
 
+    //MIX
+    delayMixSlider.setBounds(delayFeedbackSlider.getRight(), startY, sliderWidth, sliderHeight);
+    delayMixLabel.setBounds(delayMixSlider.getX(), delayMixSlider.getY()-labelYOffset, delayMixSlider.getWidth(), labelHeight);
+
 
 }
 
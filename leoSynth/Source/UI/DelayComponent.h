@@ -18,7 +18,7 @@
 class DelayComponent  : public juce::Component
 {
 public:
-    DelayComponent(juce::AudioProcessorValueTreeState& apvts, juce::String delayTimeId, juce::String delayFeedbackId);
+    DelayComponent(juce::AudioProcessorValueTreeState& apvts, juce::String delayTimeId, juce::String delayFeedbackId, juce::String delayMixId);
     ~DelayComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -28,10 +28,13 @@ private:
     using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     juce::Slider delayTimeSlider;
     juce::Slider delayFeedbackSlider;
+    juce::Slider delayMixSlider;
     std::unique_ptr<Attachment> delayTimeAttachment;
     std::unique_ptr<Attachment> delayFeedbackAttachment;
+    std::unique_ptr<Attachment> delayMixAttachment;
     juce::Label delayTimeLabel { "Delay Time", "Delay Time"};
     juce::Label delayFeedbackLabel { "Delay Feedback", "Delay Feedback" };
+    juce::Label delayMixLabel { "Delay Mix", "Delay Mix" };
     void setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<Attachment>& attachment);
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayComponent)
 };
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    EngineComponent.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "EngineComponent.h"
+
+//==============================================================================
+EngineComponent::EngineComponent(juce::AudioProcessorValueTreeState& apvts, juce::String engineSelectorId, juce::String polyphonyId, juce::String multiCoreId, juce::String multiCoreThresholdId, juce::String oversamplingId)
+{
+    engineSelector.addItemList ({ "Classic", "SIMD Bank" }, 1);
+    setComboBoxWithLabel (engineSelector, engineSelectorLabel, apvts, engineSelectorId, engineSelectorAttachment);
+    setSliderWithLabel (polyphonySlider, polyphonyLabel, apvts, polyphonyId, polyphonyAttachment);
+    setSliderWithLabel (multiCoreThresholdSlider, multiCoreThresholdLabel, apvts, multiCoreThresholdId, multiCoreThresholdAttachment);
+
+    oversamplingSelector.addItemList ({ "1x", "2x", "4x" }, 1);
+    setComboBoxWithLabel (oversamplingSelector, oversamplingSelectorLabel, apvts, oversamplingId, oversamplingSelectorAttachment);
+
+    multiCoreButton.setColour (juce::ToggleButton::ColourIds::textColourId, juce::Colours::white);
+    addAndMakeVisible (multiCoreButton);
+    multiCoreAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(apvts, multiCoreId, multiCoreButton);
+}
+
+EngineComponent::~EngineComponent()
+{
+}
+
+void EngineComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().reduced (5);
+    auto labelSpace = bounds.removeFromTop (25.0f);
+    g.fillAll (juce::Colours::black);
+    g.setColour (juce::Colours::white);
+    g.setFont (20.0f);
+    g.drawText ("Engine", labelSpace.withX (5), juce::Justification::left);
+    g.drawRoundedRectangle (bounds.toFloat(), 5.0f, 2.0f);
+}
+
+void EngineComponent::resized()
+{
+    const auto startY = 55;
+    const auto labelYOffset = 20;
+    const auto labelHeight = 20;
+
+    //ENGINE
+    engineSelector.setBounds (10, startY + 5, 110, 30);
+    engineSelectorLabel.setBounds (10, startY - labelYOffset, 110, labelHeight);
+
+    //POLYPHONY
+    polyphonySlider.setBounds (engineSelector.getRight() + 10, startY, 120, 30);
+    polyphonyLabel.setBounds (polyphonySlider.getX(), startY - labelYOffset, polyphonySlider.getWidth(), labelHeight);
+
+    //MULTI-CORE
+    multiCoreButton.setBounds (polyphonySlider.getRight() + 10, startY + 5, 100, 30);
+    multiCoreThresholdSlider.setBounds (multiCoreButton.getRight() + 10, startY, 120, 30);
+    multiCoreThresholdLabel.setBounds (multiCoreThresholdSlider.getX(), startY - labelYOffset, multiCoreThresholdSlider.getWidth(), labelHeight);
+
+    //OVERSAMPLING
+    oversamplingSelector.setBounds (multiCoreThresholdSlider.getRight() + 10, startY + 5, 90, 30);
+    oversamplingSelectorLabel.setBounds (oversamplingSelector.getX(), startY - labelYOffset, oversamplingSelector.getWidth(), labelHeight);
+}
+
+void EngineComponent::setComboBoxWithLabel (juce::ComboBox& comboBox, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>& attachment)
+{
+    addAndMakeVisible (comboBox);
+    attachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(apvts, paramId, comboBox);
+
+    label.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    label.setFont (15.0f);
+    label.setJustificationType (juce::Justification::left);
+    addAndMakeVisible (label);
+}
+
+void EngineComponent::setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment)
+{
+    slider.setSliderStyle (juce::Slider::SliderStyle::LinearHorizontal);
+    slider.setTextBoxStyle (juce::Slider::TextBoxRight, true, 40, 25);
+    addAndMakeVisible (slider);
+
+    attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(apvts, paramId, slider);
+
+    label.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    label.setFont (15.0f);
+    label.setJustificationType (juce::Justification::left);
+    addAndMakeVisible (label);
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    EngineComponent.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+*/
+class EngineComponent  : public juce::Component
+{
+public:
+    EngineComponent(juce::AudioProcessorValueTreeState& apvts, juce::String engineSelectorId, juce::String polyphonyId, juce::String multiCoreId, juce::String multiCoreThresholdId, juce::String oversamplingId);
+    ~EngineComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    juce::ComboBox engineSelector { "Voice Engine" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> engineSelectorAttachment;
+
+    juce::Slider polyphonySlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> polyphonyAttachment;
+
+    juce::ToggleButton multiCoreButton { "Multi-core" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> multiCoreAttachment;
+
+    juce::Slider multiCoreThresholdSlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> multiCoreThresholdAttachment;
+
+    juce::ComboBox oversamplingSelector { "Oversampling" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingSelectorAttachment;
+
+    juce::Label engineSelectorLabel { "Voice Engine", "Voice Engine" };
+    juce::Label polyphonyLabel { "Polyphony", "Polyphony" };
+    juce::Label multiCoreThresholdLabel { "Min Voices", "Min Voices" };
+    juce::Label oversamplingSelectorLabel { "Oversampling", "Oversampling" };
+
+    void setComboBoxWithLabel (juce::ComboBox& comboBox, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>& attachment);
+    void setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment);
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EngineComponent)
+};
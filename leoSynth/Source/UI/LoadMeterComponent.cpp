@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    LoadMeterComponent.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LoadMeterComponent.h"
+
+//==============================================================================
+LoadMeterComponent::LoadMeterComponent (LoadMeter& meterToShow)
+    : meter (meterToShow)
+{
+    startTimerHz (4);
+}
+
+LoadMeterComponent::~LoadMeterComponent()
+{
+    stopTimer();
+}
+
+void LoadMeterComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().reduced (5, 0);
+
+    g.fillAll (juce::Colours::black);
+    g.setColour (snapshot.numOverruns > 0 ? juce::Colours::orange : juce::Colours::white);
+    g.setFont (14.0f);
+
+    juce::String text;
+    text << "CPU p50 " << juce::String (snapshot.loadP50, 1) << "%  p99 " << juce::String (snapshot.loadP99, 1)
+         << "%  max " << juce::String (snapshot.loadMax, 1) << "%   overruns " << juce::String ((juce::int64) snapshot.numOverruns)
+         << "   voices p99 " << snapshot.voicesP99 << "  max " << snapshot.voicesMax;
+
+    g.drawText (text, bounds, juce::Justification::centredLeft);
+}
+
+void LoadMeterComponent::mouseDown (const juce::MouseEvent&)
+{
+    meter.reset();
+}
+
+void LoadMeterComponent::timerCallback()
+{
+    snapshot = meter.getSnapshot();
+    repaint();
+}
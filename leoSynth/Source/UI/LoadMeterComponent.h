@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    LoadMeterComponent.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../LoadMeter.h"
+
+//==============================================================================
+/*
+    One line of audio thread load figures, polled from the processor's
+    LoadMeter a few times a second. Clicking it starts the statistics over.
+*/
+class LoadMeterComponent  : public juce::Component,
+                            private juce::Timer
+{
+public:
+    LoadMeterComponent (LoadMeter& meterToShow);
+    ~LoadMeterComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+
+private:
+    void timerCallback() override;
+
+    LoadMeter& meter;
+    LoadMeter::Snapshot snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadMeterComponent)
+};
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    ModMatrixComponent.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ModMatrixComponent.h"
+
+//==============================================================================
+ModMatrixComponent::ModMatrixComponent (juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < (int) lfos.size(); ++i)
+    {
+        auto& lfo = lfos[(size_t) i];
+        const auto id = "LFO" + juce::String (i + 1);
+
+        setLabel (lfo.label, i == 0 ? "LFO 1 (voice)" : "LFO 2 (global)");
+        setComboBox (lfo.shape, ModMatrixData::getLfoShapeNames(), apvts, id + "SHAPE", lfo.shapeAttachment);
+        setSlider (lfo.rate, apvts, id + "RATE", lfo.rateAttachment);
+    }
+
+    for (int i = 0; i < (int) slots.size(); ++i)
+    {
+        auto& slot = slots[(size_t) i];
+        const auto id = "MOD" + juce::String (i + 1);
+
+        setLabel (slot.label, "Slot " + juce::String (i + 1));
+        setComboBox (slot.source, ModMatrixData::getSourceNames(), apvts, id + "SRC", slot.sourceAttachment);
+        setComboBox (slot.destination, ModMatrixData::getDestinationNames(), apvts, id + "DST", slot.destinationAttachment);
+        setSlider (slot.amount, apvts, id + "AMT", slot.amountAttachment);
+    }
+}
+
+ModMatrixComponent::~ModMatrixComponent()
+{
+}
+
+void ModMatrixComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().reduced (5);
+    auto labelSpace = bounds.removeFromTop (25.0f);
+
+    g.fillAll (juce::Colours::black);
+    g.setColour (juce::Colours::white);
+    g.setFont (20.0f);
+    g.drawText ("Modulation", labelSpace.withX (5), juce::Justification::left);
+    g.drawRoundedRectangle (bounds.toFloat(), 5.0f, 2.0f);
+}
+
+void ModMatrixComponent::resized()
+{
+    const auto startX = 15;
+    const auto width = getWidth() - 2 * startX;
+    const auto labelHeight = 20;
+    const auto rowHeight = 30;
+    auto y = 40;
+
+    //LFO
+    for (auto& lfo : lfos)
+    {
+        lfo.label.setBounds (startX, y, width, labelHeight);
+        lfo.shape.setBounds (startX, y + labelHeight, 90, rowHeight);
+        lfo.rate.setBounds (lfo.shape.getRight() + 5, y + labelHeight, width - 95, rowHeight);
+        y += labelHeight + rowHeight + 15;
+    }
+
+    //SLOTS
+    for (auto& slot : slots)
+    {
+        slot.label.setBounds (startX, y, width, labelHeight);
+        slot.source.setBounds (startX, y + labelHeight, 130, rowHeight);
+        slot.destination.setBounds (slot.source.getRight() + 5, y + labelHeight, width - 135, rowHeight);
+        slot.amount.setBounds (startX, y + labelHeight + rowHeight + 5, width, rowHeight);
+        y += labelHeight + 2 * rowHeight + 25;
+    }
+}
+
+void ModMatrixComponent::setLabel (juce::Label& label, const juce::String& text)
+{
+    label.setText (text, juce::dontSendNotification);
+    label.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    label.setFont (15.0f);
+    label.setJustificationType (juce::Justification::left);
+    addAndMakeVisible (label);
+}
+
+void ModMatrixComponent::setComboBox (juce::ComboBox& comboBox, const juce::StringArray& items, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<ComboBoxAttachment>& attachment)
+{
+    comboBox.addItemList (items, 1);
+    addAndMakeVisible (comboBox);
+    attachment = std::make_unique<ComboBoxAttachment>(apvts, paramId, comboBox);
+}
+
+void ModMatrixComponent::setSlider (juce::Slider& slider, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<SliderAttachment>& attachment)
+{
+    slider.setSliderStyle (juce::Slider::SliderStyle::LinearHorizontal);
+    slider.setTextBoxStyle (juce::Slider::TextBoxRight, true, 60, 25);
+    addAndMakeVisible (slider);
+
+    attachment = std::make_unique<SliderAttachment>(apvts, paramId, slider);
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    ModMatrixComponent.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Data/ModMatrixData.h"
+
+//==============================================================================
+/*
+    The two LFOs and the routing slots. Parameter IDs follow createParams():
+    LFO1SHAPE, LFO1RATE, ... and MOD<n>SRC, MOD<n>DST, MOD<n>AMT per slot.
+*/
+class ModMatrixComponent  : public juce::Component
+{
+public:
+    ModMatrixComponent (juce::AudioProcessorValueTreeState& apvts);
+    ~ModMatrixComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+
+    struct Lfo
+    {
+        juce::Label label;
+        juce::ComboBox shape;
+        juce::Slider rate;
+        std::unique_ptr<ComboBoxAttachment> shapeAttachment;
+        std::unique_ptr<SliderAttachment> rateAttachment;
+    };
+
+    struct Slot
+    {
+        juce::Label label;
+        juce::ComboBox source;
+        juce::ComboBox destination;
+        juce::Slider amount;
+        std::unique_ptr<ComboBoxAttachment> sourceAttachment;
+        std::unique_ptr<ComboBoxAttachment> destinationAttachment;
+        std::unique_ptr<SliderAttachment> amountAttachment;
+    };
+
+    void setLabel (juce::Label& label, const juce::String& text);
+    void setComboBox (juce::ComboBox& comboBox, const juce::StringArray& items, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<ComboBoxAttachment>& attachment);
+    void setSlider (juce::Slider& slider, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<SliderAttachment>& attachment);
+
+    std::array<Lfo, 2> lfos;
+    std::array<Slot, ModMatrixData::numSlots> slots;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModMatrixComponent)
+};
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    MpeComponent.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "MpeComponent.h"
+
+//==============================================================================
+MpeComponent::MpeComponent(juce::AudioProcessorValueTreeState& apvts, juce::String mpeId, juce::String bendRangeId)
+{
+    mpeButton.setColour (juce::ToggleButton::ColourIds::textColourId, juce::Colours::white);
+    addAndMakeVisible (mpeButton);
+    mpeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(apvts, mpeId, mpeButton);
+
+    bendRangeSlider.setSliderStyle (juce::Slider::SliderStyle::LinearHorizontal);
+    bendRangeSlider.setTextBoxStyle (juce::Slider::TextBoxRight, true, 40, 25);
+    addAndMakeVisible (bendRangeSlider);
+    bendRangeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(apvts, bendRangeId, bendRangeSlider);
+
+    bendRangeLabel.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    bendRangeLabel.setFont (15.0f);
+    bendRangeLabel.setJustificationType (juce::Justification::left);
+    addAndMakeVisible (bendRangeLabel);
+}
+
+MpeComponent::~MpeComponent()
+{
+}
+
+void MpeComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().reduced (5);
+    auto labelSpace = bounds.removeFromTop (25.0f);
+    g.fillAll (juce::Colours::black);
+    g.setColour (juce::Colours::white);
+    g.setFont (20.0f);
+    g.drawText ("MPE", labelSpace.withX (5), juce::Justification::left);
+    g.drawRoundedRectangle (bounds.toFloat(), 5.0f, 2.0f);
+}
+
+void MpeComponent::resized()
+{
+    const auto startY = 55;
+    const auto labelYOffset = 20;
+    const auto labelHeight = 20;
+
+    mpeButton.setBounds (10, startY + 5, 140, 30);
+
+    bendRangeSlider.setBounds (mpeButton.getRight() + 10, startY, 120, 30);
+    bendRangeLabel.setBounds (bendRangeSlider.getX(), startY - labelYOffset, bendRangeSlider.getWidth(), labelHeight);
+}
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    MpeComponent.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+*/
+class MpeComponent  : public juce::Component
+{
+public:
+    MpeComponent(juce::AudioProcessorValueTreeState& apvts, juce::String mpeId, juce::String bendRangeId);
+    ~MpeComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    juce::ToggleButton mpeButton { "MPE (lower zone)" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> mpeAttachment;
+
+    juce::Slider bendRangeSlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bendRangeAttachment;
+
+    juce::Label bendRangeLabel { "Bend Range", "Bend Range" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MpeComponent)
+};
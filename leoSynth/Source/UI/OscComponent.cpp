@@ -11,7 +11,7 @@
 #include "OscComponent.h"
 
 //==============================================================================
-OscComponent::OscComponent (juce::AudioProcessorValueTreeState& apvts, juce::String waveSelectorId, juce::String fmFreqId, juce::String fmDepthId, juce::String gainId, juce::String pitchId, juce::String oscName)
+OscComponent::OscComponent (juce::AudioProcessorValueTreeState& apvts, juce::String waveSelectorId, juce::String fmFreqId, juce::String fmDepthId, juce::String fmModeId, juce::String fmRatioId, juce::String gainId, juce::String pitchId, juce::String unisonId, juce::String detuneId, juce::String blendId, juce::String phaseRandomId, juce::String oscName)
 {
     juce::StringArray choices { "Sine", "Saw", "Square" };
     oscWaveSelector.addItemList (choices, 1);
@@ -23,12 +23,40 @@ OscComponent::OscComponent (juce::AudioProcessorValueTreeState& apvts, juce::Str
      waveSelectorLabel.setFont (15.0f);
     waveSelectorLabel.setJustificationType (juce::Justification::left);
     addAndMakeVisible (waveSelectorLabel);
+
+    fmModeSelector.addItemList ({ "Fixed", "Ratio" }, 1);
+    addAndMakeVisible (fmModeSelector);
+    fmModeSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(apvts, fmModeId, fmModeSelector);
+
+    fmModeLabel.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    fmModeLabel.setFont (15.0f);
+    fmModeLabel.setJustificationType (juce::Justification::left);
+    addAndMakeVisible (fmModeLabel);
+
     setSliderWithLabel (fmFreqSlider, fmFreqLabel, apvts, fmFreqId, fmFreqAttachment);
+    setSliderWithLabel (fmRatioSlider, fmRatioLabel, apvts, fmRatioId, fmRatioAttachment);
     setSliderWithLabel (fmDepthSlider, fmDepthLabel, apvts, fmDepthId, fmDepthAttachment);
     setSliderWithLabel(gainSlider, gainLabel, apvts, gainId, gainAttachment);
     setSliderWithLabel(pitchSlider, pitchLabel, apvts, pitchId, pitchAttachment);
+    setSliderWithLabel (unisonSlider, unisonLabel, apvts, unisonId, unisonAttachment);
+    setSliderWithLabel (detuneSlider, detuneLabel, apvts, detuneId, detuneAttachment);
+    setSliderWithLabel (blendSlider, blendLabel, apvts, blendId, blendAttachment);
+    setSliderWithLabel (phaseRandomSlider, phaseRandomLabel, apvts, phaseRandomId, phaseRandomAttachment);
     setTitle(oscName);
-        
+
+    // Fixed mode shows the frequency knob, ratio mode the ratio in its place
+    fmModeSelector.onChange = [this] { updateFmControls(); };
+    updateFmControls();
+}
+
+void OscComponent::updateFmControls()
+{
+    const auto ratioMode = fmModeSelector.getSelectedItemIndex() == 1;
+
+    fmFreqSlider.setVisible (! ratioMode);
+    fmFreqLabel.setVisible (! ratioMode);
+    fmRatioSlider.setVisible (ratioMode);
+    fmRatioLabel.setVisible (ratioMode);
 }
 OscComponent::~OscComponent()
 {
@@ -64,6 +92,8 @@ void OscComponent::resized()
 
      fmFreqSlider.setBounds (oscWaveSelector.getRight(), startY, sliderWidth, sliderHeight);
      fmFreqLabel.setBounds (fmFreqSlider.getX(), fmFreqSlider.getY() - labelYOffset, fmFreqSlider.getWidth(), labelHeight);
+     fmRatioSlider.setBounds (fmFreqSlider.getBounds());
+     fmRatioLabel.setBounds (fmFreqLabel.getBounds());
 
      fmDepthSlider.setBounds (fmFreqSlider.getRight(), startY, sliderWidth, sliderHeight);
      fmDepthLabel.setBounds (fmDepthSlider.getX(), fmDepthSlider.getY() - labelYOffset, fmDepthSlider.getWidth(), labelHeight);
@@ -73,6 +103,22 @@ void OscComponent::resized()
     
     pitchSlider.setBounds(fmDepthSlider.getX(), fmDepthSlider.getBottom()+paddingY, sliderWidth, sliderHeight);
     pitchLabel.setBounds(pitchSlider.getX(), pitchSlider.getY()-labelYOffset, pitchSlider.getWidth(), labelHeight);
+
+    fmModeSelector.setBounds (10, gainSlider.getY() + 5, 90, 30);
+    fmModeLabel.setBounds (10, gainSlider.getY() - labelYOffset, 90, labelHeight);
+
+    //UNISON
+    unisonSlider.setBounds (fmDepthSlider.getRight(), startY, sliderWidth, sliderHeight);
+    unisonLabel.setBounds (unisonSlider.getX(), unisonSlider.getY() - labelYOffset, unisonSlider.getWidth(), labelHeight);
+
+    detuneSlider.setBounds (unisonSlider.getRight(), startY, sliderWidth, sliderHeight);
+    detuneLabel.setBounds (detuneSlider.getX(), detuneSlider.getY() - labelYOffset, detuneSlider.getWidth(), labelHeight);
+
+    blendSlider.setBounds (unisonSlider.getX(), unisonSlider.getBottom() + paddingY, sliderWidth, sliderHeight);
+    blendLabel.setBounds (blendSlider.getX(), blendSlider.getY() - labelYOffset, blendSlider.getWidth(), labelHeight);
+
+    phaseRandomSlider.setBounds (detuneSlider.getX(), detuneSlider.getBottom() + paddingY, sliderWidth, sliderHeight);
+    phaseRandomLabel.setBounds (phaseRandomSlider.getX(), phaseRandomSlider.getY() - labelYOffset, phaseRandomSlider.getWidth(), labelHeight);
 }
 
 using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
@@ -18,7 +18,7 @@ class OscComponent  : public juce::Component
 {
 public:
     
-    OscComponent (juce::AudioProcessorValueTreeState& apvts, juce::String waveSelectorId, juce::String fmFreqId, juce::String fmDepthId, juce::String gainId,juce::String pitchId,juce::String oscName);
+    OscComponent (juce::AudioProcessorValueTreeState& apvts, juce::String waveSelectorId, juce::String fmFreqId, juce::String fmDepthId, juce::String fmModeId, juce::String fmRatioId, juce::String gainId,juce::String pitchId, juce::String unisonId, juce::String detuneId, juce::String blendId, juce::String phaseRandomId, juce::String oscName);
     ~OscComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -30,26 +30,45 @@ private:
     juce::String title;
     juce::ComboBox oscWaveSelector;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oscWaveSelectorAttachment;
+    juce::ComboBox fmModeSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> fmModeSelectorAttachment;
     
     juce::Slider fmFreqSlider;
+    juce::Slider fmRatioSlider;
     juce::Slider fmDepthSlider;
     juce::Slider gainSlider;
     juce::Slider pitchSlider;
+    juce::Slider unisonSlider;
+    juce::Slider detuneSlider;
+    juce::Slider blendSlider;
+    juce::Slider phaseRandomSlider;
     
     using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     
     std::unique_ptr<Attachment> fmFreqAttachment;
+    std::unique_ptr<Attachment> fmRatioAttachment;
     std::unique_ptr<Attachment> fmDepthAttachment;
     std::unique_ptr<Attachment> gainAttachment;
     std::unique_ptr<Attachment> pitchAttachment;
+    std::unique_ptr<Attachment> unisonAttachment;
+    std::unique_ptr<Attachment> detuneAttachment;
+    std::unique_ptr<Attachment> blendAttachment;
+    std::unique_ptr<Attachment> phaseRandomAttachment;
     
     juce::Label waveSelectorLabel { "Wave Type", "Wave Type" };
+    juce::Label fmModeLabel { "FM Mode", "FM Mode" };
     juce::Label fmFreqLabel { "FM Freq", "FM Freq" };
+    juce::Label fmRatioLabel { "FM Ratio", "FM Ratio" };
     juce::Label fmDepthLabel { "FM Depth", "FM Depth" };
     juce::Label gainLabel {"Gain", "Gain"};
     juce::Label pitchLabel{"Pitch", "Pitch"};
+    juce::Label unisonLabel { "Unison", "Unison" };
+    juce::Label detuneLabel { "Detune", "Detune" };
+    juce::Label blendLabel { "Blend", "Blend" };
+    juce::Label phaseRandomLabel { "Phase", "Phase" };
     
     
+    void updateFmControls();
     void setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<Attachment>& attachment);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OscComponent)
@@ -12,11 +12,11 @@
 #include "Oscilloscope.h"
 
 //==============================================================================
-Oscilloscope::Oscilloscope()
+Oscilloscope::Oscilloscope (ScopeFifo& source)
+    : fifo (source)
 {
-    // In your constructor, you should add any child components, and
-    // initialise any special settings that your component needs.
-
+    incoming.calloc (ScopeFifo::capacity);
+    history.calloc (historySize);
 }
 
 Oscilloscope::~Oscilloscope()
@@ -32,18 +32,115 @@ void Oscilloscope::paint (juce::Graphics& g)
          g.setFont (20.0f);
          g.drawText ("Oscilloscope", labelSpace.withX (5), juce::Justification::left);
          g.drawRoundedRectangle (bounds.toFloat(), 5.0f, 2.0f);
+
+    const auto centre = (float) plotArea.getCentreY();
+    const auto halfHeight = (float) plotArea.getHeight() * 0.5f;
+
+    g.setColour (juce::Colours::darkgrey);
+    g.drawHorizontalLine ((int) centre, (float) plotArea.getX(), (float) plotArea.getRight());
+
+    g.setColour (juce::Colours::lime);
+
+    for (int x = 0; x < columnMin.size(); ++x)
+    {
+        // Higher values are further up, so the max gives the top of the line
+        const auto top = centre - juce::jlimit (-1.0f, 1.0f, columnMax[x]) * halfHeight;
+        const auto bottom = centre - juce::jlimit (-1.0f, 1.0f, columnMin[x]) * halfHeight;
+
+        g.drawVerticalLine (plotArea.getX() + x, top, juce::jmax (bottom, top + 1.0f));
+    }
 }
 
 void Oscilloscope::resized()
 {
-    /*
-    const auto startY = 55;
-    const auto sliderWidth = 100;
-    const auto sliderHeight = 90;
-    const auto labelYOffset = 20;
-    const auto labelHeight = 20;
-     */
-   
+    auto bounds = getLocalBounds().reduced (5);
+    bounds.removeFromTop (25);
+    plotArea = bounds.reduced (5);
+
+    columnMin.resize (juce::jmax (0, plotArea.getWidth()));
+    columnMax.resize (juce::jmax (0, plotArea.getWidth()));
+    decimate();
+}
+
+//==============================================================================
+void Oscilloscope::update()
+{
+    // Drained every refresh, so the fifo never fills while the editor is open
+    pullSamples();
+
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+
+    if (! hasNewSamples || now - lastRepaintMs < 1000.0 / maxFramesPerSecond)
+        return;
+
+    lastRepaintMs = now;
+    hasNewSamples = false;
+
+    decimate();
+    repaint();
+}
+
+void Oscilloscope::pullSamples()
+{
+    const auto numPulled = fifo.pull (incoming, ScopeFifo::capacity);
+
+    if (numPulled == 0)
+        return;
+
+    // The history is kept linear, newest sample last
+    const auto numNew = juce::jmin (numPulled, historySize);
+    const auto numKept = historySize - numNew;
+
+    std::memmove (history.get(), history + numNew, (size_t) numKept * sizeof (float));
+    juce::FloatVectorOperations::copy (history + numKept, incoming + (numPulled - numNew), numNew);
+
+    hasNewSamples = true;
 }
 
+int Oscilloscope::findTrigger (int windowSamples) const
+{
+    // The last rising crossing that still leaves a full window after it; the
+    // signal has to dip below the hysteresis band first, so noise does not re-arm
+    const auto searchEnd = historySize - windowSamples;
+    const auto searchStart = juce::jmax (0, searchEnd - windowSamples);
+
+    auto trigger = -1;
+    auto armed = false;
+
+    for (int i = searchStart; i <= searchEnd; ++i)
+    {
+        if (history[i] < triggerLevel - triggerHysteresis)
+        {
+            armed = true;
+        }
+        else if (armed && history[i] >= triggerLevel)
+        {
+            trigger = i;
+            armed = false;
+        }
+    }
 
+    // Free-running when nothing crosses
+    return trigger >= 0 ? trigger : searchEnd;
+}
+
+void Oscilloscope::decimate()
+{
+    const auto numColumns = columnMin.size();
+
+    if (numColumns == 0)
+        return;
+
+    const auto windowSamples = juce::jlimit (numColumns, historySize / 2, (int) (fifo.getSampleRate() * windowSeconds));
+    const auto start = findTrigger (windowSamples);
+
+    for (int x = 0; x < numColumns; ++x)
+    {
+        const auto from = start + (int) ((juce::int64) x * windowSamples / numColumns);
+        const auto to = start + (int) ((juce::int64) (x + 1) * windowSamples / numColumns);
+        const auto range = juce::FloatVectorOperations::findMinAndMax (history + from, juce::jmax (1, to - from));
+
+        columnMin.set (x, range.getStart());
+        columnMax.set (x, range.getEnd());
+    }
+}
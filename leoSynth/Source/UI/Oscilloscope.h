@@ -11,19 +11,48 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "../ScopeFifo.h"
 
 //==============================================================================
 /*
+    Draws the processor output pulled from a ScopeFifo. Samples are drained on
+    every display refresh into a history, a rising zero crossing is looked for
+    so periodic waves stand still, and the window is reduced to one min/max
+    pair per pixel column. Repaints are capped at maxFramesPerSecond.
 */
 class Oscilloscope  : public juce::Component
 {
 public:
-    Oscilloscope();
+    Oscilloscope (ScopeFifo& source);
     ~Oscilloscope() override;
 
     void paint (juce::Graphics&) override;
     void resized() override;
 
 private:
+    static constexpr int historySize = 1 << 14;
+    static constexpr double windowSeconds = 0.025;
+    static constexpr double maxFramesPerSecond = 30.0;
+    static constexpr float triggerLevel = 0.0f;
+    static constexpr float triggerHysteresis = 0.01f;
+
+    void update();
+    void pullSamples();
+    int findTrigger (int windowSamples) const;
+    void decimate();
+
+    ScopeFifo& fifo;
+
+    juce::HeapBlock<float> incoming;
+    juce::HeapBlock<float> history;
+    juce::Array<float> columnMin;
+    juce::Array<float> columnMax;
+    juce::Rectangle<int> plotArea;
+
+    bool hasNewSamples { false };
+    double lastRepaintMs { 0.0 };
+
+    juce::VBlankAttachment vBlankAttachment { this, [this] { update(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oscilloscope)
 };
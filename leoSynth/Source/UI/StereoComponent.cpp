@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    StereoComponent.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "StereoComponent.h"
+
+//==============================================================================
+StereoComponent::StereoComponent(juce::AudioProcessorValueTreeState& apvts, juce::String panId, juce::String spreadId, juce::String decorrelationId)
+{
+    setSliderWithLabel(panSlider, panLabel, apvts, panId, panAttachment);
+    setSliderWithLabel(spreadSlider, spreadLabel, apvts, spreadId, spreadAttachment);
+    setSliderWithLabel(decorrelationSlider, decorrelationLabel, apvts, decorrelationId, decorrelationAttachment);
+}
+
+StereoComponent::~StereoComponent()
+{
+}
+
+void StereoComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().reduced (5);
+    auto labelSpace = bounds.removeFromTop (25.0f);
+    g.fillAll (juce::Colours::black);
+    g.setColour (juce::Colours::white);
+    g.setFont (20.0f);
+    g.drawText ("Stereo", labelSpace.withX (5), juce::Justification::left);
+    g.drawRoundedRectangle (bounds.toFloat(), 5.0f, 2.0f);
+}
+
+void StereoComponent::resized()
+{
+    const auto startY = 55;
+    const auto sliderWidth = 90;
+    const auto sliderHeight = 90;
+    const auto labelYOffset = 20;
+    const auto labelHeight = 20;
+
+    //PAN
+    panSlider.setBounds (10, startY + 5, sliderWidth, sliderHeight);
+    panLabel.setBounds (panSlider.getX(), startY - labelYOffset, sliderWidth, labelHeight);
+
+    //SPREAD
+    spreadSlider.setBounds (panSlider.getRight(), startY + 5, sliderWidth, sliderHeight);
+    spreadLabel.setBounds (spreadSlider.getX(), startY - labelYOffset, sliderWidth, labelHeight);
+
+    //DECORRELATION
+    decorrelationSlider.setBounds (spreadSlider.getRight(), startY + 5, sliderWidth, sliderHeight);
+    decorrelationLabel.setBounds (decorrelationSlider.getX(), startY - labelYOffset, sliderWidth, labelHeight);
+}
+
+using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+
+void StereoComponent::setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<Attachment>& attachment)
+{
+    slider.setSliderStyle (juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    slider.setTextBoxStyle (juce::Slider::TextBoxBelow, true, 50, 25);
+    addAndMakeVisible (slider);
+
+    attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(apvts, paramId, slider);
+
+    label.setColour (juce::Label::ColourIds::textColourId, juce::Colours::white);
+    label.setFont (15.0f);
+    label.setJustificationType (juce::Justification::centred);
+    addAndMakeVisible (label);
+}
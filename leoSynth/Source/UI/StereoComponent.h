@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    StereoComponent.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+*/
+class StereoComponent  : public juce::Component
+{
+public:
+    StereoComponent(juce::AudioProcessorValueTreeState& apvts, juce::String panId, juce::String spreadId, juce::String decorrelationId);
+    ~StereoComponent() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    juce::Slider panSlider;
+    juce::Slider spreadSlider;
+    juce::Slider decorrelationSlider;
+    std::unique_ptr<Attachment> panAttachment;
+    std::unique_ptr<Attachment> spreadAttachment;
+    std::unique_ptr<Attachment> decorrelationAttachment;
+    juce::Label panLabel { "Pan", "Pan" };
+    juce::Label spreadLabel { "Spread", "Spread" };
+    juce::Label decorrelationLabel { "Decorrelation", "Decorrelation" };
+    void setSliderWithLabel (juce::Slider& slider, juce::Label& label, juce::AudioProcessorValueTreeState& apvts, juce::String paramId, std::unique_ptr<Attachment>& attachment);
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StereoComponent)
+};
@@ -0,0 +1,635 @@
+/*
+  ==============================================================================
+
+    VoicePool.cpp
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#include "VoicePool.h"
+
+VoicePool::VoicePool()
+{
+    owner.fill (nullptr);
+}
+
+VoicePool::~VoicePool()
+{
+    renderPool.stop();
+    releaseArena();
+}
+
+void VoicePool::allocateArena()
+{
+    constexpr size_t cacheLineSize = 64;
+
+    arenaStorage.malloc (maxVoices * sizeof (SynthVoice) + cacheLineSize);
+    arena = reinterpret_cast<SynthVoice*> (juce::snapPointerToAlignment (arenaStorage.get(), cacheLineSize));
+
+    for (int i = 0; i < maxVoices; ++i)
+    {
+        voices.add (new (arena + i) SynthVoice());
+        arena[i].setModMatrix (&modMatrix);
+        arena[i].setPitchBendRange (mpe ? mpeBendRange : masterBendRange);
+    }
+}
+
+void VoicePool::releaseArena()
+{
+    if (arena == nullptr)
+        return;
+
+    // The arena owns the voices, not the OwnedArray
+    voices.clear (false);
+
+    for (int i = 0; i < maxVoices; ++i)
+        arena[i].~SynthVoice();
+
+    arena = nullptr;
+    arenaStorage.free();
+}
+
+void VoicePool::prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (arena == nullptr)
+            allocateArena();
+
+        preparedBlockSize = samplesPerBlock;
+        preparedChannels = outputChannels;
+    }
+
+    setRenderSampleRate (sampleRate);
+
+    // Off the audio thread there is time to prepare every voice up front
+    for (int i = 0; i < maxVoices; ++i)
+        prepareVoice (i);
+
+    // The workers only run in multi-core mode
+    if (multiCore && renderPool.getNumWorkers() == 0)
+        renderPool.start (juce::SystemStats::getNumCpus() - 1);
+
+    allocatePartials();
+}
+
+void VoicePool::allocatePartials()
+{
+    const juce::ScopedLock sl (lock);
+
+    // The serial path reuses one partial; the parallel one needs a partial per voice
+    const auto numPartials = renderPool.getNumWorkers() > 0 ? maxVoices : 1;
+    partials.setSize (numPartials * maxPartialChannels, windowLength);
+    parallelPartials = numPartials > 1;
+}
+
+void VoicePool::setRenderSampleRate (double sampleRate)
+{
+    const juce::ScopedLock sl (lock);
+    jassert (arena != nullptr);
+
+    allNotesOff (0, false);
+    setCurrentPlaybackSampleRate (sampleRate);
+    modMatrix.setSampleRate (sampleRate);
+
+    // Nothing sounds any more, so rather than re-preparing all the voices in
+    // one block, each one is re-prepared as it next starts
+    renderSampleRate = sampleRate;
+
+    held = {};
+    releasing = {};
+    owner.fill (nullptr);
+
+    // Lowest index on top, so a light patch keeps touching the same few voices
+    for (numFree = 0; numFree < maxVoices; ++numFree)
+        freeStack[numFree] = maxVoices - 1 - numFree;
+}
+
+void VoicePool::prepareVoice (int index)
+{
+    arena[index].prepareToPlay (renderSampleRate, preparedBlockSize, preparedChannels);
+    voiceRate[(size_t) index] = renderSampleRate;
+}
+
+void VoicePool::releaseResources()
+{
+    renderPool.stop();
+    allocatePartials();
+}
+
+void VoicePool::setMultiCore (bool shouldUseWorkers, int minVoices)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        multiCoreThreshold = juce::jmax (2, minVoices);
+
+        if (shouldUseWorkers == multiCore)
+            return;
+
+        // Switched off before the workers go, so no block is handed to them
+        multiCore = shouldUseWorkers;
+    }
+
+    if (shouldUseWorkers)
+        renderPool.start (juce::SystemStats::getNumCpus() - 1);
+    else
+        renderPool.stop();
+
+    allocatePartials();
+}
+
+void VoicePool::setMpe (bool shouldUseMpe, float bendRange)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (mpe && ! shouldUseMpe)
+        modMatrix.setMasterPitchBend (0.0f);
+
+    mpe = shouldUseMpe;
+    mpeBendRange = bendRange;
+
+    // Takes effect from the next bend message or note
+    for (int i = 0; i < maxVoices && arena != nullptr; ++i)
+        arena[i].setPitchBendRange (mpe ? mpeBendRange : masterBendRange);
+}
+
+void VoicePool::setPolyphony (int numVoices)
+{
+    // Lowering the limit never cuts voices, it only makes new notes steal
+    polyphony = juce::jlimit (1, maxVoices, numVoices);
+}
+
+//==============================================================================
+void VoicePool::noteOn (int midiChannel, int midiNoteNumber, float velocity)
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto* sound : sounds)
+    {
+        if (sound->appliesToNote (midiNoteNumber) && sound->appliesToChannel (midiChannel))
+        {
+            // A note still ringing because of a pedal is let go before it is hit again
+            for (auto index = held.head; index >= 0;)
+            {
+                const auto following = next[index];
+                auto& voice = arena[index];
+
+                if (voice.getCurrentlyPlayingNote() == midiNoteNumber && voice.isPlayingChannel (midiChannel))
+                    releaseVoice (index, 1.0f, true);
+
+                index = following;
+            }
+
+            const auto index = allocateVoice();
+
+            if (index >= 0)
+            {
+                if (voiceRate[(size_t) index] != renderSampleRate)
+                    prepareVoice (index);
+
+                if (voiceSetup != nullptr)
+                    voiceSetup (voiceSetupContext, arena[index], index);
+
+                startVoice (arena + index, sound, midiChannel, midiNoteNumber, velocity);
+                arena[index].setInitialExpression (channelPressure[(size_t) midiChannel - 1], channelTimbre[(size_t) midiChannel - 1]);
+                arena[index].setSampleTime (modMatrix.getClock() + eventTime - blockStart);
+                renderedTo[index] = eventTime;
+            }
+        }
+    }
+}
+
+void VoicePool::noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto index = held.head; index >= 0;)
+    {
+        const auto following = next[index];
+        auto& voice = arena[index];
+
+        if (voice.getCurrentlyPlayingNote() == midiNoteNumber && voice.isPlayingChannel (midiChannel))
+        {
+            if (auto sound = voice.getCurrentlyPlayingSound())
+            {
+                if (sound->appliesToNote (midiNoteNumber) && sound->appliesToChannel (midiChannel))
+                {
+                    voice.setKeyDown (false);
+
+                    if (! (voice.isSustainPedalDown() || voice.isSostenutoPedalDown()))
+                        releaseVoice (index, velocity, allowTailOff);
+                }
+            }
+        }
+
+        index = following;
+    }
+}
+
+void VoicePool::allNotesOff (int midiChannel, bool allowTailOff)
+{
+    const juce::ScopedLock sl (lock);
+
+    juce::Synthesiser::allNotesOff (midiChannel, allowTailOff);
+    reclaimVoices();
+}
+
+void VoicePool::handleController (int midiChannel, int controllerNumber, int controllerValue)
+{
+    if (controllerNumber == 1)
+        modMatrix.setModWheel ((float) controllerValue / 127.0f);
+
+    if (controllerNumber == 74 && midiChannel > 0 && midiChannel <= 16)
+        channelTimbre[(size_t) midiChannel - 1] = ExpressionData::timbreFromMidi (controllerValue);
+
+    // As juce::Synthesiser does, minus its walk over every voice in the arena
+    switch (controllerNumber)
+    {
+        case 0x40:  handleSustainPedal   (midiChannel, controllerValue >= 64); break;
+        case 0x42:  handleSostenutoPedal (midiChannel, controllerValue >= 64); break;
+        case 0x43:  handleSoftPedal      (midiChannel, controllerValue >= 64); break;
+        default:    break;
+    }
+
+    const juce::ScopedLock sl (lock);
+
+    forEachActiveVoice ([=] (SynthVoice& voice, int)
+    {
+        if (midiChannel <= 0 || voice.isPlayingChannel (midiChannel))
+            voice.controllerMoved (controllerNumber, controllerValue);
+    });
+}
+
+void VoicePool::handlePitchWheel (int midiChannel, int wheelValue)
+{
+    if (mpe && midiChannel == masterChannel)
+    {
+        modMatrix.setMasterPitchBend (ExpressionData::bendToSemitones (wheelValue, masterBendRange));
+        return;
+    }
+
+    const juce::ScopedLock sl (lock);
+
+    forEachActiveVoice ([=] (SynthVoice& voice, int)
+    {
+        if (midiChannel <= 0 || voice.isPlayingChannel (midiChannel))
+            voice.pitchWheelMoved (wheelValue);
+    });
+}
+
+void VoicePool::handleChannelPressure (int midiChannel, int channelPressureValue)
+{
+    if (midiChannel > 0 && midiChannel <= 16)
+        channelPressure[(size_t) midiChannel - 1] = ExpressionData::pressureFromMidi (channelPressureValue);
+
+    const juce::ScopedLock sl (lock);
+
+    forEachActiveVoice ([=] (SynthVoice& voice, int)
+    {
+        if (midiChannel <= 0 || voice.isPlayingChannel (midiChannel))
+            voice.channelPressureChanged (channelPressureValue);
+    });
+}
+
+void VoicePool::handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue)
+{
+    const juce::ScopedLock sl (lock);
+
+    forEachActiveVoice ([=] (SynthVoice& voice, int)
+    {
+        if (voice.getCurrentlyPlayingNote() == midiNoteNumber && (midiChannel <= 0 || voice.isPlayingChannel (midiChannel)))
+            voice.aftertouchChanged (aftertouchValue);
+    });
+}
+
+void VoicePool::renderBlock (juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& midiMessages, int startSample, int numSamples)
+{
+    const juce::ScopedLock sl (lock);
+
+    const auto endSample = startSample + numSamples;
+
+    output = &outputAudio;
+    blockStart = startSample;
+    renderedTo.fill (startSample);
+    numPending = 0;
+
+    for (auto it = midiMessages.findNextSamplePosition (startSample); it != midiMessages.end(); ++it)
+    {
+        const auto metadata = *it;
+        const auto time = metadata.samplePosition;
+
+        if (time >= endSample)
+            break;
+
+        if (numPending > 0 && time >= pendingTime)
+            applyPendingControls (pendingTime);
+
+        const auto message = metadata.getMessage();
+
+        if (message.isNoteOnOrOff())
+        {
+            // A note's initial bend and pressure come just before its note-on,
+            // so anything held back is applied first
+            if (numPending > 0 && message.isNoteOn())
+                applyPendingControls (time);
+
+            // Only the voices the note starts, steals or releases catch up to it
+            eventTime = time;
+            handleMidiEvent (message);
+        }
+        else if (isContinuousControl (message))
+        {
+            // Held back to the next control tick, so a dense CC or pitch bend
+            // stream splits the voices at most once per tick. A full queue is
+            // applied a little early instead, never out of order
+            if (numPending == (int) pending.size())
+                applyPendingControls (time);
+
+            if (numPending == 0)
+                pendingTime = juce::jmin (endSample, startSample + (time - startSample + controlInterval - 1) / controlInterval * controlInterval);
+
+            pending[(size_t) numPending++] = { metadata.data, metadata.numBytes };
+        }
+        else
+        {
+            // Pedals and the rest may touch any voice
+            renderUpTo (time);
+            eventTime = time;
+            handleMidiEvent (message);
+        }
+    }
+
+    if (numPending > 0)
+        applyPendingControls (pendingTime);
+
+    renderUpTo (endSample);
+    output = nullptr;
+    modMatrix.advanceClock (numSamples);
+}
+
+void VoicePool::renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    // Only reached through juce::Synthesiser::renderNextBlock, which has already
+    // split the block at every event
+    output = &outputAudio;
+    blockStart = eventTime = startSample;
+    renderedTo.fill (startSample);
+    renderUpTo (startSample + numSamples);
+    output = nullptr;
+    modMatrix.advanceClock (numSamples);
+}
+
+bool VoicePool::isContinuousControl (const juce::MidiMessage& message) noexcept
+{
+    if (message.isPitchWheel() || message.isAftertouch() || message.isChannelPressure())
+        return true;
+
+    // Not the pedals, whose order against the notes matters, nor the channel mode messages
+    if (message.isController())
+    {
+        const auto number = message.getControllerNumber();
+        return number < 120 && number != 64 && number != 66 && number != 67;
+    }
+
+    return false;
+}
+
+void VoicePool::applyPendingControls (int time)
+{
+    renderUpTo (time);
+    eventTime = time;
+
+    for (int i = 0; i < numPending; ++i)
+        handleMidiEvent (juce::MidiMessage (pending[(size_t) i].data, pending[(size_t) i].numBytes));
+
+    numPending = 0;
+}
+
+void VoicePool::renderUpTo (int time)
+{
+    // In windows of at most windowLength, which is what a partial holds,
+    // starting from the voice that is furthest behind. The windows never
+    // depend on how they are rendered
+    for (;;)
+    {
+        auto windowStart = time;
+
+        for (auto* list : { &releasing, &held })
+            for (auto index = list->head; index >= 0; index = next[index])
+                windowStart = juce::jmin (windowStart, renderedTo[index]);
+
+        if (windowStart >= time)
+            return;
+
+        const auto windowEnd = juce::jmin (time, windowStart + windowLength);
+
+        if (multiCore && parallelPartials && getNumActiveVoices() >= multiCoreThreshold)
+            renderWindowInParallel (windowStart, windowEnd);
+        else
+            renderWindow (windowStart, windowEnd);
+    }
+}
+
+void VoicePool::renderPartial (int index, int partial, int windowStart, int windowEnd)
+{
+    // The partial covers the window from windowStart and starts out silent, so
+    // the voice leaves exactly its own samples in it
+    const auto numChannels = juce::jmin (output->getNumChannels(), maxPartialChannels);
+    float* channels[maxPartialChannels] {};
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = partials.getWritePointer (partial * maxPartialChannels + ch);
+
+    juce::AudioBuffer<float> buffer (channels, numChannels, windowEnd - windowStart);
+    const auto start = renderedTo[index];
+
+    buffer.clear (start - windowStart, windowEnd - start);
+    arena[index].renderNextBlock (buffer, start - windowStart, windowEnd - start);
+}
+
+void VoicePool::addPartial (int index, int partial, int windowStart, int windowEnd)
+{
+    const auto numChannels = juce::jmin (output->getNumChannels(), maxPartialChannels);
+    const auto start = renderedTo[index];
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::add (output->getWritePointer (ch, start),
+                                          partials.getReadPointer (partial * maxPartialChannels + ch, start - windowStart),
+                                          windowEnd - start);
+}
+
+void VoicePool::renderWindow (int windowStart, int windowEnd)
+{
+    // Releasing first: held voices whose pedal came up move over to that list
+    // here and must not be rendered twice
+    for (auto* list : { &releasing, &held })
+    {
+        for (auto index = list->head; index >= 0;)
+        {
+            const auto following = next[index];
+
+            if (renderedTo[index] < windowEnd)
+            {
+                renderPartial (index, 0, windowStart, windowEnd);
+                addPartial (index, 0, windowStart, windowEnd);
+                renderedTo[index] = windowEnd;
+                updateVoiceState (index);
+            }
+
+            index = following;
+        }
+    }
+}
+
+void VoicePool::renderWindowInParallel (int windowStart, int windowEnd)
+{
+    // Same voice order as the loop above; a voice that stops inside the window
+    // only moves between lists once every job is done
+    numJobs = 0;
+
+    for (auto* list : { &releasing, &held })
+    {
+        for (auto index = list->head; index >= 0; index = next[index])
+        {
+            if (renderedTo[index] >= windowEnd)
+                continue;
+
+            jobVoices[(size_t) numJobs] = index;
+            ++numJobs;
+        }
+    }
+
+    jobWindowStart = windowStart;
+    jobEnd = windowEnd;
+    renderPool.run (&VoicePool::renderJob, this, numJobs);
+
+    // Summed in the serial path's order with the same adds, so both give the
+    // same bits whatever thread rendered which voice
+    for (int i = 0; i < numJobs; ++i)
+        addPartial (jobVoices[(size_t) i], i, windowStart, windowEnd);
+
+    for (int i = 0; i < numJobs; ++i)
+    {
+        renderedTo[jobVoices[(size_t) i]] = windowEnd;
+        updateVoiceState (jobVoices[(size_t) i]);
+    }
+}
+
+void VoicePool::renderJob (void* context, int item)
+{
+    // Item n renders the n-th voice into partial n
+    auto& pool = *static_cast<VoicePool*> (context);
+    pool.renderPartial (pool.jobVoices[(size_t) item], item, pool.jobWindowStart, pool.jobEnd);
+}
+
+void VoicePool::catchUp (int index)
+{
+    if (output == nullptr)
+        return;
+
+    if (renderedTo[index] < eventTime)
+        arena[index].renderNextBlock (*output, renderedTo[index], eventTime - renderedTo[index]);
+
+    renderedTo[index] = eventTime;
+}
+
+//==============================================================================
+int VoicePool::allocateVoice()
+{
+    int index = -1;
+
+    if (numFree > 0 && getNumActiveVoices() < polyphony)
+    {
+        index = freeStack[--numFree];
+    }
+    else if (isNoteStealingEnabled())
+    {
+        index = releasing.head >= 0 ? releasing.head : held.head;
+
+        if (index >= 0)
+        {
+            unlink (index);
+            catchUp (index);
+        }
+    }
+
+    if (index >= 0)
+        pushBack (held, index);
+
+    return index;
+}
+
+void VoicePool::releaseVoice (int index, float velocity, bool allowTailOff)
+{
+    catchUp (index);
+    arena[index].stopNote (velocity, allowTailOff);
+    updateVoiceState (index);
+}
+
+void VoicePool::updateVoiceState (int index)
+{
+    auto& voice = arena[index];
+
+    if (! voice.isVoiceActive())
+    {
+        unlink (index);
+        freeStack[numFree++] = index;
+    }
+    else if (owner[index] == &held && ! (voice.isKeyDown() || voice.isSustainPedalDown() || voice.isSostenutoPedalDown()))
+    {
+        unlink (index);
+        pushBack (releasing, index);
+    }
+}
+
+void VoicePool::reclaimVoices()
+{
+    for (auto* list : { &releasing, &held })
+    {
+        for (auto index = list->head; index >= 0;)
+        {
+            const auto following = next[index];
+            updateVoiceState (index);
+            index = following;
+        }
+    }
+}
+
+//==============================================================================
+void VoicePool::pushBack (List& list, int index) noexcept
+{
+    jassert (owner[index] == nullptr);
+
+    prev[index] = list.tail;
+    next[index] = -1;
+
+    if (list.tail >= 0)
+        next[list.tail] = index;
+    else
+        list.head = index;
+
+    list.tail = index;
+    ++list.size;
+    owner[index] = &list;
+}
+
+void VoicePool::unlink (int index) noexcept
+{
+    auto* list = owner[index];
+    jassert (list != nullptr);
+
+    if (prev[index] >= 0)
+        next[prev[index]] = next[index];
+    else
+        list->head = next[index];
+
+    if (next[index] >= 0)
+        prev[next[index]] = prev[index];
+    else
+        list->tail = prev[index];
+
+    --list->size;
+    owner[index] = nullptr;
+}
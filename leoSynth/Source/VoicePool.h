@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    VoicePool.h
+    Author:  Leonardo Mannini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SynthVoice.h"
+#include "RenderThreadPool.h"
+
+// juce::Synthesiser whose voices live in one contiguous, cache-line aligned
+// arena allocated in prepareToPlay. Sounding voices are threaded on intrusive
+// lists, so idle voices are never visited while rendering, and a note-on takes
+// a voice from a free stack or steals one from the head of a list in O(1).
+//
+// Voices are stolen from the releasing list first (the one released longest
+// ago, i.e. the quietest) and only then from the held list (the oldest note).
+// MIDI parsing and pedals are still handled by juce::Synthesiser; controllers,
+// pitch bend and pressure only visit the sounding voices.
+//
+// renderBlock schedules the block itself instead of splitting every voice at
+// every MIDI event. A note on or off only brings the voices it starts, steals or
+// releases up to its sample; pedals and the like bring all of them; controllers,
+// pitch bend and pressure are held back to the next control tick, so a dense
+// stream of them costs at most one split per tick. Voices otherwise render in
+// long contiguous runs.
+//
+// Pitch bend, pressure and CC74 already reach only the voices playing on their
+// channel, which is all MPE needs of the routing. With MPE on, the voices bend
+// over the per-note range and channel 1, the lower zone's master channel, bends
+// every voice through the matrix instead. Each channel's last pressure and
+// timbre are kept, so a note picks up what was sent just before its note-on.
+//
+// The pool owns the mod matrix the voices read. Its clock counts the samples
+// rendered, so the global LFO has one phase however the voices are scheduled;
+// the mod wheel is picked up here rather than per voice, so new notes see it.
+//
+// Voices keep no buffers. Each one renders a window into a cleared partial,
+// which is then added to the output, one voice after another in list order.
+// With multi-core rendering on and enough voices sounding, the voices render
+// their partials on a RenderThreadPool instead, one partial per voice, and
+// the partials are added in the same order with the same adds. The parallel
+// output is therefore bit-identical to the serial one, whatever the number of
+// threads or the voice count threshold.
+class VoicePool : public juce::Synthesiser
+{
+public:
+    static constexpr int maxVoices = 256;
+
+    VoicePool();
+    ~VoicePool() override;
+
+    // samplesPerBlock is the largest block the voices will ever be asked for
+    void prepareToPlay (double sampleRate, int samplesPerBlock, int outputChannels);
+    void releaseResources();
+
+    // Switches the voices to another rate, e.g. when oversampling changes.
+    // Cuts every note; each voice is re-prepared when it next starts, so a
+    // call on the audio thread costs next to nothing
+    void setRenderSampleRate (double sampleRate);
+
+    // Number of voices that may sound at once, 1 to maxVoices
+    void setPolyphony (int numVoices);
+    int getPolyphony() const noexcept { return polyphony; }
+    int getNumActiveVoices() const noexcept { return held.size + releasing.size; }
+
+    // Use this rather than renderNextBlock
+    void renderBlock (juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+
+    // Message thread only: starts or stops the render workers and their
+    // per-voice partials. Below minVoices sounding voices the block is still rendered serially
+    void setMultiCore (bool shouldUseWorkers, int minVoices);
+
+    // MPE lower zone: member channels 2 to 16 bend by up to bendRange semitones
+    void setMpe (bool shouldUseMpe, float bendRange);
+    bool isMpe() const noexcept { return mpe; }
+
+    // Called on the audio thread for each voice just before it starts a note,
+    // with its index in the arena
+    using VoiceSetup = void (*) (void* context, SynthVoice& voice, int index);
+    void setVoiceSetup (VoiceSetup setup, void* context) noexcept { voiceSetup = setup; voiceSetupContext = context; }
+
+    // Calls function (voice, index) for every held and releasing voice
+    template <typename Function>
+    void forEachActiveVoice (Function&& function)
+    {
+        for (auto* list : { &held, &releasing })
+            for (auto index = list->head; index >= 0; index = next[index])
+                function (arena[index], index);
+    }
+
+    ModMatrixData& getModMatrix() noexcept { return modMatrix; }
+
+    void noteOn (int midiChannel, int midiNoteNumber, float velocity) override;
+    void noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+    void allNotesOff (int midiChannel, bool allowTailOff) override;
+    void handleController (int midiChannel, int controllerNumber, int controllerValue) override;
+    void handlePitchWheel (int midiChannel, int wheelValue) override;
+    void handleChannelPressure (int midiChannel, int channelPressureValue) override;
+    void handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue) override;
+
+protected:
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
+private:
+    struct List
+    {
+        int head { -1 };
+        int tail { -1 };
+        int size { 0 };
+    };
+
+    static constexpr int controlInterval = FilterData::controlInterval;
+
+    static bool isContinuousControl (const juce::MidiMessage& message) noexcept;
+    void applyPendingControls (int time);
+    void renderUpTo (int time);
+    void renderWindow (int windowStart, int windowEnd);
+    void renderWindowInParallel (int windowStart, int windowEnd);
+    void renderPartial (int index, int partial, int windowStart, int windowEnd);
+    void addPartial (int index, int partial, int windowStart, int windowEnd);
+    static void renderJob (void* context, int item);
+    void allocatePartials();
+    void catchUp (int index);
+
+    void prepareVoice (int index);
+    void allocateArena();
+    void releaseArena();
+
+    int allocateVoice();
+    void releaseVoice (int index, float velocity, bool allowTailOff);
+    void updateVoiceState (int index);
+    void reclaimVoices();
+
+    void pushBack (List& list, int index) noexcept;
+    void unlink (int index) noexcept;
+
+    juce::HeapBlock<char> arenaStorage;
+    SynthVoice* arena { nullptr };
+
+    // Intrusive links, indexed like the arena
+    std::array<int, maxVoices> prev;
+    std::array<int, maxVoices> next;
+    std::array<List*, maxVoices> owner;
+
+    List held;        // key or pedal still down, in note-on order
+    List releasing;   // tailing off, in note-off order
+    std::array<int, maxVoices> freeStack;
+    int numFree { 0 };
+    int polyphony { maxVoices };
+    int preparedBlockSize { 0 };
+    int preparedChannels { 0 };
+    double renderSampleRate { 0.0 };
+    std::array<double, maxVoices> voiceRate {};   // the rate each voice was last prepared for
+
+    ModMatrixData modMatrix;
+    VoiceSetup voiceSetup { nullptr };
+    void* voiceSetupContext { nullptr };
+
+    static constexpr int masterChannel = 1;
+    static constexpr float masterBendRange = 2.0f;
+    bool mpe { false };
+    float mpeBendRange { 48.0f };
+    std::array<float, 16> channelPressure {};
+    std::array<float, 16> channelTimbre {};
+
+    RenderThreadPool renderPool;
+    bool multiCore { false };
+    int multiCoreThreshold { 8 };
+    std::array<int, maxVoices> jobVoices;
+    int numJobs { 0 };
+    int jobWindowStart { 0 };
+    int jobEnd { 0 };
+
+    // maxPartialChannels channels per partial, each windowLength long and
+    // covering the window from its start. One partial serially, one per voice
+    // while the workers run
+    static constexpr int windowLength = 256;
+    static constexpr int maxPartialChannels = 2;
+    juce::AudioBuffer<float> partials;
+    bool parallelPartials { false };
+
+    // Scheduler state while renderBlock runs: the sample each voice has been
+    // rendered up to, and the time of the event being handled
+    juce::AudioBuffer<float>* output { nullptr };
+    std::array<int, maxVoices> renderedTo {};
+    int eventTime { 0 };
+    int blockStart { 0 };
+
+    struct PendingControl
+    {
+        const juce::uint8* data;
+        int numBytes;
+    };
+
+    std::array<PendingControl, 64> pending;
+    int numPending { 0 };
+    int pendingTime { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoicePool)
+};
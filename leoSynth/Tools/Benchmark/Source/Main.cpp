@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Author:  Leonardo Mannini
+
+    Microbenchmarks for leoSynthAudioProcessor::processBlock and for each DSP
+    stage on its own. Every case reports ns per sample frame and the realtime
+    factor, as CSV or JSON, so two builds can be diffed.
+
+    Build the Release configuration; Debug numbers mean nothing.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/PluginProcessor.h"
+
+namespace
+{
+    const juce::StringArray waveNames { "sine", "saw", "square" };
+    const juce::StringArray filterNames { "lowpass", "bandpass", "highpass" };
+
+    struct Result
+    {
+        juce::String stage;
+        int voices { -1 };      // -1 where a field does not apply to the stage
+        int blockSize { 0 };
+        double sampleRate { 0.0 };
+        int wave { -1 };
+        int filter { -1 };
+        double nsPerSample { 0.0 };
+        double realtimeFactor { 0.0 };
+    };
+
+    struct Options
+    {
+        juce::Array<int> voices { 1, 8, 32, 128 };
+        juce::Array<int> blockSizes { 1, 64, 512, 2048 };
+        juce::Array<int> sampleRates { 48000 };
+        juce::Array<int> waves { 0, 1, 2 };
+        juce::Array<int> filters { 0 };
+        juce::StringArray stages { "processBlock", "voice", "voiceReference", "osc", "oscUnison", "filter", "adsr" };
+        juce::String overrides;
+        int eventsPerBlock { 0 };
+        double seconds { 1.0 };
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: Benchmark [options]\n"
+                     "\n"
+                     "  --stages a,b,...    processBlock,voice,voiceReference,osc,oscUnison,filter,adsr (default: all)\n"
+                     "  --voices 1,8,...    voice counts (default 1,8,32,128)\n"
+                     "  --block 1,64,...    block sizes (default 1,64,512,2048)\n"
+                     "  --rate 48000,...    sample rates (default 48000)\n"
+                     "  --wave 0,1,2        0 sine, 1 saw, 2 square (default all)\n"
+                     "  --filter 0,1,2      0 low-pass, 1 band-pass, 2 high-pass (default 0)\n"
+                     "  --set ID=v,ID=v     extra processor parameters, e.g. MULTICORE=1\n"
+                     "  --events <n>        mod wheel and pitch bend messages per processBlock block (default 0)\n"
+                     "  --seconds <s>       audio time measured per case (default 1)\n"
+                     "  --format csv|json   output format (default csv)\n"
+                     "  --out <file>        write there instead of stdout\n"
+                     "  --label <text>      tag every row, e.g. with the commit being measured\n";
+    }
+
+    juce::Array<int> parseList (const juce::String& text)
+    {
+        juce::Array<int> values;
+
+        for (auto& token : juce::StringArray::fromTokens (text, ",", {}))
+            values.add (token.getIntValue());
+
+        return values;
+    }
+
+    // Runs process() for about the given stretch of audio, after a short warm-up
+    template <typename Process>
+    void measure (Result& result, Process&& process, double seconds)
+    {
+        const auto numBlocks = juce::jmax (1, (int) (seconds * result.sampleRate / result.blockSize));
+
+        for (int i = 0; i < juce::jmax (1, numBlocks / 10); ++i)
+            process();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            process();
+
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        const auto numSamples = (double) numBlocks * result.blockSize;
+
+        result.nsPerSample = elapsed * 1.0e9 / numSamples;
+        result.realtimeFactor = elapsed > 0.0 ? numSamples / result.sampleRate / elapsed : 0.0;
+    }
+
+    void setParameter (leoSynthAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    //==============================================================================
+    void benchProcessBlock (Result& result, const Options& options)
+    {
+        leoSynthAudioProcessor processor;
+        processor.setNonRealtime (true);
+
+        setParameter (processor, "POLYPHONY", (float) result.voices);
+        setParameter (processor, "OSCWAVETYPE", (float) result.wave);
+        setParameter (processor, "OSCWAVETYPE2", (float) result.wave);
+        setParameter (processor, "FILTERTYPE", (float) result.filter);
+
+        for (auto& token : juce::StringArray::fromTokens (options.overrides, ",", {}))
+            setParameter (processor, token.upToFirstOccurrenceOf ("=", false, false).trim(),
+                          token.fromFirstOccurrenceOf ("=", false, false).getFloatValue());
+
+        processor.setRateAndBufferSizeDetails (result.sampleRate, result.blockSize);
+        processor.prepareToPlay (result.sampleRate, result.blockSize);
+
+        juce::AudioBuffer<float> buffer (processor.getTotalNumOutputChannels(), result.blockSize);
+        juce::MidiBuffer midi;
+
+        // Every voice is started in the first block and held; spread over
+        // channels so more than 96 voices never retrigger the same note
+        for (int i = 0; i < result.voices; ++i)
+            midi.addEvent (juce::MidiMessage::noteOn (1 + i / 96, 24 + i % 96, 0.8f), 0);
+
+        measure (result, [&]
+        {
+            buffer.clear();
+            processor.processBlock (buffer, midi);
+            midi.clear();
+
+            // Dense controller traffic for the next block, spread evenly over it
+            for (int i = 0; i < options.eventsPerBlock; ++i)
+            {
+                const auto position = i * result.blockSize / options.eventsPerBlock;
+                midi.addEvent (i % 2 == 0 ? juce::MidiMessage::controllerEvent (1, 1, i % 128)
+                                          : juce::MidiMessage::pitchWheel (1, 8192 + (i % 64) * 64), position);
+            }
+        }, options.seconds);
+
+        processor.releaseResources();
+    }
+
+    // One held voice, whole chain; voiceReference runs the multi-pass kernel
+    void benchVoice (Result& result, const Options& options, bool reference)
+    {
+        // Started through a Synthesiser, so the voice knows it is playing
+        juce::Synthesiser synth;
+        auto* voice = new SynthVoice();
+        synth.addVoice (voice);
+        synth.addSound (new SynthSound());
+        synth.setCurrentPlaybackSampleRate (result.sampleRate);
+
+        voice->prepareToPlay (result.sampleRate, result.blockSize, 2);
+        voice->setReferenceKernel (reference);
+        voice->getOscillator1().setWaveType (result.wave);
+        voice->getOscillator2().setWaveType (result.wave);
+        voice->getAdsr().updateADSR (0.1f, 0.1f, 0.5f, 0.4f);
+        voice->getModAdsr().updateADSR (0.5f, 0.5f, 0.5f, 0.4f);
+        voice->setFilterParams (result.filter, 1000.0f, 2.0f);
+        synth.noteOn (1, 60, 0.8f);
+
+        juce::AudioBuffer<float> output (2, result.blockSize);
+
+        measure (result, [&]
+        {
+            output.clear();
+            voice->renderNextBlock (output, 0, result.blockSize);
+        }, options.seconds);
+    }
+
+    // With unison, a stack of 8 detuned copies
+    void benchOsc (Result& result, const Options& options, bool unison)
+    {
+        OscData osc;
+        osc.prepareToPlay (result.sampleRate, result.blockSize, 1);
+        osc.setWaveType (result.wave);
+        osc.setGain (0.0f);
+        osc.setWaveFrequency (60);
+
+        if (unison)
+        {
+            osc.setUnison (8, 25.0f, 1.0f, 1.0f);
+            osc.retriggerUnison();
+        }
+
+        juce::HeapBlock<float> output (result.blockSize);
+
+        measure (result, [&]
+        {
+            juce::FloatVectorOperations::clear (output.get(), result.blockSize);
+            osc.renderNextBlock (output.get(), result.blockSize);
+        }, options.seconds);
+    }
+
+    void benchFilter (Result& result, const Options& options)
+    {
+        FilterData filter;
+        filter.prepareToPlay (result.sampleRate, result.blockSize, 2);
+        filter.setParams (result.filter, 1000.0f, 2.0f);
+
+        juce::AudioBuffer<float> input (2, result.blockSize);
+        juce::AudioBuffer<float> buffer (2, result.blockSize);
+        juce::Random random (1);
+
+        for (int ch = 0; ch < input.getNumChannels(); ++ch)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                input.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+        // Keeps the cutoff gliding, as under a moving mod envelope
+        int samplesUntilTick = 0;
+        int tick = 0;
+
+        measure (result, [&]
+        {
+            buffer.makeCopyOf (input, true);
+
+            for (int start = 0; start < result.blockSize;)
+            {
+                if (samplesUntilTick == 0)
+                {
+                    filter.setModulation ((++tick & 1) != 0 ? 0.25f : 1.0f, FilterData::controlInterval);
+                    samplesUntilTick = FilterData::controlInterval;
+                }
+
+                const auto n = juce::jmin (samplesUntilTick, result.blockSize - start);
+                filter.process (buffer, start, n);
+                start += n;
+                samplesUntilTick -= n;
+            }
+        }, options.seconds);
+    }
+
+    void benchAdsr (Result& result, const Options& options)
+    {
+        AdsrData adsr;
+        adsr.setSampleRate (result.sampleRate);
+        adsr.updateADSR (0.1f, 0.1f, 0.5f, 0.4f);
+
+        juce::AudioBuffer<float> buffer (2, result.blockSize);
+
+        // Retriggered twice a second, so attack and decay are measured too
+        const auto retriggerSamples = (int) (result.sampleRate / 2.0);
+        int samplesSinceNoteOn = retriggerSamples;
+
+        measure (result, [&]
+        {
+            if (samplesSinceNoteOn >= retriggerSamples)
+            {
+                adsr.noteOn();
+                samplesSinceNoteOn = 0;
+            }
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), 1.0f, result.blockSize);
+
+            adsr.applyEnvelopeToBuffer (buffer, 0, result.blockSize);
+            samplesSinceNoteOn += result.blockSize;
+        }, options.seconds);
+    }
+
+    //==============================================================================
+    juce::Array<Result> makeCases (const Options& options)
+    {
+        juce::Array<Result> cases;
+
+        for (auto& stage : options.stages)
+        {
+            const auto usesVoices = stage == "processBlock";
+            const auto usesVoice = stage == "processBlock" || stage.startsWith ("voice");
+            const auto usesWave = usesVoice || stage.startsWith ("osc");
+            const auto usesFilter = usesVoice || stage == "filter";
+
+            for (auto rate : options.sampleRates)
+                for (auto block : options.blockSizes)
+                    for (auto voices : usesVoices ? options.voices : juce::Array<int> { -1 })
+                        for (auto wave : usesWave ? options.waves : juce::Array<int> { -1 })
+                            for (auto filter : usesFilter ? options.filters : juce::Array<int> { -1 })
+                                cases.add ({ stage, voices, block, (double) rate, wave, filter });
+        }
+
+        return cases;
+    }
+
+    bool run (Result& result, const Options& options)
+    {
+        if (result.stage == "processBlock")  benchProcessBlock (result, options);
+        else if (result.stage == "voice")    benchVoice (result, options, false);
+        else if (result.stage == "voiceReference") benchVoice (result, options, true);
+        else if (result.stage == "osc")      benchOsc (result, options, false);
+        else if (result.stage == "oscUnison") benchOsc (result, options, true);
+        else if (result.stage == "filter")   benchFilter (result, options);
+        else if (result.stage == "adsr")     benchAdsr (result, options);
+        else                                 return false;
+
+        return true;
+    }
+
+    bool isValid (const Options& options)
+    {
+        auto allWithin = [] (const juce::Array<int>& values, int minimum, int maximum)
+        {
+            for (auto v : values)
+                if (v < minimum || v > maximum)
+                    return false;
+
+            return true;
+        };
+
+        juce::String error;
+
+        if (! allWithin (options.voices, 1, VoicePool::maxVoices))            error = "voices must be 1 to " + juce::String (VoicePool::maxVoices);
+        else if (! allWithin (options.blockSizes, 1, 1 << 16))                error = "bad block size";
+        else if (! allWithin (options.sampleRates, 1, 1 << 22))               error = "bad sample rate";
+        else if (! allWithin (options.waves, 0, waveNames.size() - 1))        error = "bad wave";
+        else if (! allWithin (options.filters, 0, filterNames.size() - 1))    error = "bad filter";
+        else if (options.seconds <= 0.0)                                      error = "bad --seconds";
+        else if (options.eventsPerBlock < 0)                                  error = "bad --events";
+
+        if (error.isNotEmpty())
+            std::cerr << "Benchmark: " << error.toStdString() << std::endl;
+
+        return error.isEmpty();
+    }
+
+    juce::String nameOrEmpty (const juce::StringArray& names, int index)
+    {
+        return index >= 0 ? names[index] : juce::String();
+    }
+
+    juce::String toCsv (const juce::Array<Result>& results, const juce::String& label)
+    {
+        juce::String csv ("label,stage,voices,block,rate,wave,filter,ns_per_sample,realtime_factor\n");
+
+        for (auto& r : results)
+        {
+            csv << label << "," << r.stage << ","
+                << (r.voices >= 0 ? juce::String (r.voices) : juce::String()) << ","
+                << r.blockSize << "," << (int) r.sampleRate << ","
+                << nameOrEmpty (waveNames, r.wave) << "," << nameOrEmpty (filterNames, r.filter) << ","
+                << juce::String (r.nsPerSample, 3) << "," << juce::String (r.realtimeFactor, 3) << "\n";
+        }
+
+        return csv;
+    }
+
+    juce::String toJson (const juce::Array<Result>& results, const juce::String& label)
+    {
+        auto quoted = [] (const juce::String& s) { return s.isEmpty() ? juce::String ("null") : s.quoted(); };
+
+        juce::String json;
+        json << "{\n"
+             << "  \"label\": " << quoted (label) << ",\n"
+             << "  \"cpu\": " << quoted (juce::SystemStats::getCpuModel()) << ",\n"
+             << "  \"numCpus\": " << juce::SystemStats::getNumCpus() << ",\n"
+             << "  \"results\": [\n";
+
+        for (int i = 0; i < results.size(); ++i)
+        {
+            auto& r = results.getReference (i);
+
+            json << "    { \"stage\": " << r.stage.quoted()
+                 << ", \"voices\": " << (r.voices >= 0 ? juce::String (r.voices) : juce::String ("null"))
+                 << ", \"block\": " << r.blockSize
+                 << ", \"rate\": " << (int) r.sampleRate
+                 << ", \"wave\": " << quoted (nameOrEmpty (waveNames, r.wave))
+                 << ", \"filter\": " << quoted (nameOrEmpty (filterNames, r.filter))
+                 << ", \"nsPerSample\": " << juce::String (r.nsPerSample, 3)
+                 << ", \"realtimeFactor\": " << juce::String (r.realtimeFactor, 3)
+                 << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        json << "  ]\n}\n";
+        return json;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ScopedNoDenormals noDenormals;
+
+    Options options;
+
+    if (args.containsOption ("--stages"))   options.stages = juce::StringArray::fromTokens (args.getValueForOption ("--stages"), ",", {});
+    if (args.containsOption ("--voices"))   options.voices = parseList (args.getValueForOption ("--voices"));
+    if (args.containsOption ("--block"))    options.blockSizes = parseList (args.getValueForOption ("--block"));
+    if (args.containsOption ("--rate"))     options.sampleRates = parseList (args.getValueForOption ("--rate"));
+    if (args.containsOption ("--wave"))     options.waves = parseList (args.getValueForOption ("--wave"));
+    if (args.containsOption ("--filter"))   options.filters = parseList (args.getValueForOption ("--filter"));
+    if (args.containsOption ("--seconds"))  options.seconds = args.getValueForOption ("--seconds").getDoubleValue();
+    if (args.containsOption ("--events"))   options.eventsPerBlock = args.getValueForOption ("--events").getIntValue();
+    options.overrides = args.getValueForOption ("--set");
+
+    if (! isValid (options))
+        return 1;
+
+    auto results = makeCases (options);
+
+    for (int i = 0; i < results.size(); ++i)
+    {
+        auto& result = results.getReference (i);
+
+        if (! run (result, options))
+        {
+            std::cerr << "Benchmark: unknown stage '" << result.stage.toStdString() << "'" << std::endl;
+            return 1;
+        }
+
+        std::cerr << "[" << (i + 1) << "/" << results.size() << "] " << result.stage.toStdString()
+                  << " block " << result.blockSize << ": " << result.nsPerSample << " ns/sample" << std::endl;
+    }
+
+    const auto label = args.getValueForOption ("--label");
+    const auto text = args.getValueForOption ("--format") == "json" ? toJson (results, label) : toCsv (results, label);
+
+    if (args.containsOption ("--out"))
+    {
+        const auto outFile = args.getFileForOption ("--out");
+
+        if (! outFile.replaceWithText (text))
+        {
+            std::cerr << "Benchmark: could not write " << outFile.getFullPathName().toStdString() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << text;
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Author:  Leonardo Mannini
+
+    Headless offline renderer: runs a Standard MIDI File through
+    leoSynthAudioProcessor::processBlock and writes the result as WAV or FLAC,
+    as fast as the CPU allows.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/PluginProcessor.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: OfflineRender --midi <file.mid> --out <file.wav|file.flac> [options]\n"
+                     "       OfflineRender --make-bank <file.leobank> --states <folder of .state files>\n"
+                     "\n"
+                     "  --state <file>      state saved with getStateInformation() to load first\n"
+                     "  --set ID=v,ID=v     parameter overrides, in plain units (e.g. POLYPHONY=32)\n"
+                     "  --save-state <file> write the resulting state, e.g. to build a bank from\n"
+                     "  --rate <hz>         sample rate, default 48000\n"
+                     "  --block <samples>   block size, default 512\n"
+                     "  --bits <16|24|32>   output bit depth, default 24 (FLAC: 16 or 24)\n"
+                     "  --tail <seconds>    render time after the last MIDI event, default 2\n"
+                     "  --load              print the processBlock load statistics at the end\n";
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "OfflineRender: " << message.toStdString() << std::endl;
+        return 1;
+    }
+
+    bool loadMidi (const juce::File& file, juce::MidiMessageSequence& sequence)
+    {
+        juce::FileInputStream stream (file);
+        juce::MidiFile midiFile;
+
+        if (! stream.openedOk() || ! midiFile.readFrom (stream))
+            return false;
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+            sequence.addSequence (*midiFile.getTrack (t), 0.0);
+
+        return true;
+    }
+
+    bool applyOverrides (leoSynthAudioProcessor& processor, const juce::String& overrides)
+    {
+        for (auto& token : juce::StringArray::fromTokens (overrides, ",", {}))
+        {
+            const auto id = token.upToFirstOccurrenceOf ("=", false, false).trim();
+            auto* parameter = processor.apvts.getParameter (id);
+
+            if (parameter == nullptr || ! token.contains ("="))
+            {
+                std::cerr << "OfflineRender: bad override '" << token.toStdString() << "'" << std::endl;
+                return false;
+            }
+
+            const auto value = token.fromFirstOccurrenceOf ("=", false, false).getFloatValue();
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+        }
+
+        return true;
+    }
+
+    // Programs are named after the files and sorted by name
+    int makeBank (const juce::File& bankFile, const juce::File& folder)
+    {
+        auto files = folder.findChildFiles (juce::File::findFiles, false, "*.state");
+        files.sort();
+
+        juce::StringArray names;
+        juce::Array<juce::MemoryBlock> states;
+
+        for (auto& file : files)
+        {
+            juce::MemoryBlock state;
+
+            if (! file.loadFileAsData (state))
+                return fail ("could not read " + file.getFullPathName());
+
+            names.add (file.getFileNameWithoutExtension());
+            states.add (state);
+        }
+
+        if (! PresetBank::write (bankFile, names, states))
+            return fail ("could not write " + bankFile.getFullPathName() + " (1 to " + juce::String (PresetBank::maxPrograms) + " programs)");
+
+        std::cout << bankFile.getFullPathName() << ": " << states.size() << " programs" << std::endl;
+        return 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--make-bank"))
+        return makeBank (args.getFileForOption ("--make-bank"), args.getExistingFolderForOption ("--states"));
+
+    if (args.containsOption ("--help|-h") || ! args.containsOption ("--midi") || ! args.containsOption ("--out"))
+    {
+        printUsage();
+        return args.containsOption ("--help|-h") ? 0 : 1;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto midiFile = args.getExistingFileForOption ("--midi");
+    const auto outFile = args.getFileForOption ("--out");
+    const auto sampleRate = args.containsOption ("--rate") ? args.getValueForOption ("--rate").getDoubleValue() : 48000.0;
+    const auto blockSize = args.containsOption ("--block") ? args.getValueForOption ("--block").getIntValue() : 512;
+    const auto bitDepth = args.containsOption ("--bits") ? args.getValueForOption ("--bits").getIntValue() : 24;
+    const auto tailSeconds = args.containsOption ("--tail") ? args.getValueForOption ("--tail").getDoubleValue() : 2.0;
+
+    if (sampleRate <= 0.0 || blockSize <= 0)
+        return fail ("invalid --rate or --block");
+
+    juce::MidiMessageSequence sequence;
+
+    if (! loadMidi (midiFile, sequence))
+        return fail ("could not read " + midiFile.getFullPathName());
+
+    leoSynthAudioProcessor processor;
+    processor.setNonRealtime (true);
+
+    if (args.containsOption ("--state"))
+    {
+        juce::MemoryBlock state;
+
+        if (! args.getExistingFileForOption ("--state").loadFileAsData (state))
+            return fail ("could not read the state file");
+
+        processor.setStateInformation (state.getData(), (int) state.getSize());
+    }
+
+    if (args.containsOption ("--set") && ! applyOverrides (processor, args.getValueForOption ("--set")))
+        return 1;
+
+    if (args.containsOption ("--save-state"))
+    {
+        juce::MemoryBlock state;
+        processor.getStateInformation (state);
+
+        if (! args.getFileForOption ("--save-state").replaceWithData (state.getData(), state.getSize()))
+            return fail ("could not write the state file");
+    }
+
+    const auto numChannels = processor.getTotalNumOutputChannels();
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    std::unique_ptr<juce::AudioFormat> format;
+
+    if (outFile.hasFileExtension ("flac"))
+        format = std::make_unique<juce::FlacAudioFormat>();
+    else
+        format = std::make_unique<juce::WavAudioFormat>();
+
+    outFile.deleteFile();
+    auto stream = outFile.createOutputStream();
+
+    if (stream == nullptr)
+        return fail ("could not open " + outFile.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels, bitDepth, {}, 0));
+
+    if (writer == nullptr)
+        return fail ("the output format does not support these settings");
+
+    stream.release();   // now owned by the writer
+
+    // Oversampling delays the output; that much is rendered extra and dropped from the front
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    const auto totalSamples = (juce::int64) std::ceil ((sequence.getEndTime() + tailSeconds) * sampleRate) + latency;
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    double processingMs = 0.0;
+
+    for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+    {
+        const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, totalSamples - position);
+
+        midi.clear();
+
+        for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+        {
+            const auto& message = sequence.getEventPointer (nextEvent)->message;
+            const auto eventSample = (juce::int64) std::llround (message.getTimeStamp() * sampleRate);
+
+            if (eventSample >= position + numSamples)
+                break;
+
+            if (! message.isMetaEvent())
+                midi.addEvent (message, (int) juce::jmax ((juce::int64) 0, eventSample - position));
+        }
+
+        // Always a full block, like a host would send; the last one is trimmed on write
+        buffer.clear();
+
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+        processor.processBlock (buffer, midi);
+        processingMs += juce::Time::getMillisecondCounterHiRes() - start;
+
+        const auto skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, latency - position);
+
+        if (skip < numSamples)
+            writer->writeFromAudioSampleBuffer (buffer, skip, numSamples - skip);
+    }
+
+    writer.reset();
+
+    if (args.containsOption ("--load"))
+        std::cout << "load: " << processor.getLoadMeter().getSnapshot().toString().toStdString() << std::endl;
+
+    processor.releaseResources();
+
+    // Debug builds trap heap allocations inside processBlock; any is a failure
+    const auto numAllocations = AllocationTrap::getNumAllocations();
+
+    if (AllocationTrap::isEnabled())
+        std::cout << "heap allocations on the audio thread: " << numAllocations << std::endl;
+
+    const auto audioSeconds = (double) (totalSamples - latency) / sampleRate;
+    const auto processingSeconds = processingMs / 1000.0;
+
+    std::cout << outFile.getFullPathName().toStdString() << ": "
+              << audioSeconds << " s of audio rendered in " << processingSeconds << " s, "
+              << "realtime factor " << (processingSeconds > 0.0 ? audioSeconds / processingSeconds : 0.0) << "x"
+              << std::endl;
+
+    return numAllocations > 0 ? 1 : 0;
+}